@@ -0,0 +1,161 @@
+#!/bin/sh
+set -e
+
+usage() {
+	echo "USAGE: ${0##*/} [-p quick|full] [-o OUTDIR] [-s SEEDS] [EXAMPLE...]" 1>&2
+	exit 1
+}
+
+# Directory containing the example applications.
+EXAMPLES="$(cd "$(dirname "${0}")/.." && pwd)"
+
+# Directory containing symex-vp, hifive-vp, and sps-stub.
+VP_BIN="${VP_BIN:-${EXAMPLES}/../vp/build/bin}"
+
+PROFILE=quick
+while getopts p:o:s: flag; do
+	case "${flag}" in
+	p) PROFILE="${OPTARG}" ;;
+	o) OUTDIR="${OPTARG}" ;;
+	s) SEEDS="${OPTARG}" ;;
+	*) usage ;;
+	esac
+done
+shift $((OPTIND - 1))
+
+# The quick profile is intended to finish in less than a minute.
+case "${PROFILE}" in
+quick)
+	BUDGET=10
+	SEEDS="${SEEDS:-1}"
+	;;
+full)
+	BUDGET=300
+	SEEDS="${SEEDS:-1 2 3}"
+	;;
+*)
+	usage
+	;;
+esac
+
+[ $# -eq 0 ] && set -- assertion-failure symbolic-sensor zig-out-of-bounds memory-copy
+
+OUTDIR="${OUTDIR:-$(mktemp -d "${TMPDIR:-/tmp}/symex-bench.XXXXXX")}"
+mkdir -p "${OUTDIR}"
+RESULTS="${OUTDIR}/results.jsonl"
+: > "${RESULTS}"
+
+elf_path() {
+	case "${1}" in
+	zig-*) echo "${EXAMPLES}/${1}/zig-out/bin/main" ;;
+	*) echo "${EXAMPLES}/${1}/main" ;;
+	esac
+}
+
+# Build the example unless the ELF already exists.
+build() {
+	[ -e "$(elf_path "${1}")" ] && return 0
+
+	case "${1}" in
+	zig-*) (cd "${EXAMPLES}/${1}" && zig build) 1>&2 ;;
+	*) make -C "${EXAMPLES}/${1}" 1>&2 ;;
+	esac
+}
+
+# Summarize the statistics written by the explorer (see SYMEX_STATS),
+# the coverage over time is written to a separate CSV file.
+report() {
+	[ $# -ne 3 ] && exit 1
+
+	awk -v name="${1}" -v seed="${2}" -v csv="${OUTDIR}/${1}-${2}.csv" -v results="${RESULTS}" '
+	function num(key,    m) {
+		if (!match($0, "\"" key "\":[-+.0-9eE]+"))
+			return 0
+		m = substr($0, RSTART, RLENGTH)
+		sub(/^[^:]*:/, "", m)
+		return m + 0
+	}
+	function rate(n) {
+		return (time > 0) ? n / time : 0
+	}
+	BEGIN {
+		print "time,paths,errors,branches,instr_coverage" > csv
+		first_error = "null"
+	}
+	{
+		time = num("time")
+		paths = num("paths")
+		errors = num("errors")
+		branches = num("branches")
+		coverage = num("instr_coverage")
+		instructions = num("instructions")
+		search = num("path_search")
+
+		if (first_error == "null" && errors > 0)
+			first_error = time
+		print time "," paths "," errors "," branches "," coverage > csv
+	}
+	END {
+		if (NR == 0)
+			exit 1
+
+		printf("{\"example\":\"%s\",\"seed\":%d,\"time\":%g,\"paths\":%d,\"errors\":%d," \
+		       "\"paths_per_sec\":%g,\"instructions_per_sec\":%g,\"solver_share\":%g," \
+		       "\"first_error\":%s,\"branches\":%d,\"instr_coverage\":%g}\n",
+		       name, seed, time, paths, errors, rate(paths), rate(instructions),
+		       (time > 0) ? search / time : 0, first_error, branches, coverage) >> results
+
+		printf("%-20s seed=%-4d %8.2f paths/s %12.0f instr/s %5.1f%% solver  first error: %s\n",
+		       name, seed, rate(paths), rate(instructions),
+		       (time > 0) ? 100 * search / time : 0, first_error)
+	}' "${3}"
+}
+
+# Run the given VP with fixed seed and time budget.
+run() {
+	[ $# -lt 4 ] && exit 1
+	name="${1}"; vp="${2}"; elf="${3}"; seed="${4}"
+	shift 4
+
+	stats="${OUTDIR}/${name}-${seed}.jsonl"
+	SYMEX_SEED="${seed}" SYMEX_TIMEBUDGET="${BUDGET}" \
+	SYMEX_STATS="${stats}" SYMEX_STATS_INTERVAL=1 \
+		"${VP_BIN}/${vp}" "$@" "${elf}" \
+		> "${OUTDIR}/${name}-${seed}.log" 2>&1 || true
+
+	if ! report "${name}" "${seed}" "${stats}"; then
+		echo "${name}: no statistics written, see ${OUTDIR}/${name}-${seed}.log" 1>&2
+	fi
+}
+
+for example in "$@"; do
+	if ! build "${example}"; then
+		echo "${example}: build failed, skipping" 1>&2
+		continue
+	fi
+
+	for seed in ${SEEDS}; do
+		run "${example}" symex-vp "$(elf_path "${example}")" "${seed}" --quiet
+	done
+done
+
+# An application for the hifive-vp is not part of the examples, it
+# is explored against a local SPS stand-in if specified explicitly.
+if [ -n "${HIFIVE_ELF}" ]; then
+	socket="${OUTDIR}/sps.sock"
+	"${VP_BIN}/sps-stub" -u "${socket}" ${SPS_RESPONSES:+-r "${SPS_RESPONSES}"} &
+	stub=$!
+	trap 'kill ${stub}' EXIT
+
+	# Wait for the stand-in to create the socket.
+	while [ ! -S "${socket}" ]; do
+		kill -0 ${stub} 2>/dev/null || exit 1
+		sleep 0.1
+	done
+
+	for seed in ${SEEDS}; do
+		run hifive "hifive-vp" "${HIFIVE_ELF}" "${seed}" --sps-host "unix:${socket}"
+	done
+fi
+
+echo "Results written to ${RESULTS}"
@@ -0,0 +1,61 @@
+#include <stdint.h>
+#include <stddef.h>
+
+extern void symex_error(void);
+extern void make_symbolic(void *, size_t);
+
+#define MY_ASSERT(COND) \
+	((COND) ? (void)0 : symex_error())
+
+struct header {
+	uint8_t type;
+	uint8_t flags;
+	uint16_t length;
+	uint32_t checksum;
+};
+
+struct packet {
+	struct header hdr;
+	uint8_t payload[8];
+};
+
+/* The compiler emits calls to memcpy for struct copies */
+void *
+memcpy(void *dest, const void *src, size_t n)
+{
+	uint8_t *d = dest;
+	const uint8_t *s = src;
+
+	while (n--)
+		*d++ = *s++;
+	return dest;
+}
+
+static uint32_t
+checksum(const uint8_t *buf, size_t len)
+{
+	uint32_t sum = 0;
+
+	for (size_t i = 0; i < len; i++)
+		sum = (sum << 1) + buf[i];
+	return sum;
+}
+
+int
+main(void)
+{
+	uint8_t input[sizeof(struct packet)];
+	struct packet pkt, copy;
+
+	make_symbolic(input, sizeof(input));
+	memcpy(&pkt, input, sizeof(pkt));
+	copy = pkt;
+
+	if (copy.hdr.type != 2 || copy.hdr.length > sizeof(copy.payload))
+		return 0;
+
+	if (copy.hdr.checksum == checksum(copy.payload, copy.hdr.length))
+		MY_ASSERT(!(copy.hdr.flags & 0x80));
+
+	return 0;
+}
@@ -0,0 +1,33 @@
+#!/bin/sh
+set -e
+
+# Number of replayed test cases and replay workers.
+TESTS=64
+JOBS=2
+
+# Wall time budget per test case in milliseconds. A single test case
+# finishes well within this budget, the test cases of a worker do not.
+WALLTIME=500
+
+TESTDIR="$(mktemp -d "${TMPDIR:-/tmp}/replay-budget.XXXXXX")"
+trap 'rm -rf "${TESTDIR}"' EXIT
+
+# Empty test cases assign random values to all symbolic variables,
+# each of them terminates regardless of the assignment.
+i=0
+while [ ${i} -lt ${TESTS} ]; do
+	: > "${TESTDIR}/test${i}"
+	i=$((i + 1))
+done
+
+output="$(SYMEX_TESTCASE="${TESTDIR}" SYMEX_JOBS=${JOBS} SYMEX_MAXWALLTIME=${WALLTIME} \
+	"${SYMEX_VP:-symex-vp}" --quiet main 2>&1 || true)"
+
+expected="Test cases: ${TESTS} (${TESTS} passed, 0 failed)"
+if ! printf '%s\n' "${output}" | grep -qF "${expected}"; then
+	printf '%s\n' "${output}" 1>&2
+	echo "FAIL: expected '${expected}'" 1>&2
+	exit 1
+fi
+
+echo "PASS: ${expected}"
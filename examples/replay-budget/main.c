@@ -0,0 +1,21 @@
+#include <stdint.h>
+#include <stddef.h>
+
+extern void make_symbolic(void *, size_t);
+
+/* Number of loop iterations, the wall time budget is only checked
+ * periodically and thus requires a sufficient number of instructions. */
+#define ITERATIONS 10000
+
+int
+main(void)
+{
+	volatile uint32_t counter = 0;
+	uint8_t offset;
+
+	make_symbolic(&offset, sizeof(offset));
+	for (uint32_t i = 0; i < ITERATIONS + offset; i++)
+		counter++;
+
+	return 0;
+}
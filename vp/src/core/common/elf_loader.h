@@ -137,19 +137,30 @@ struct GenericElfLoader {
 		return elf.data() + s->sh_offset;
 	}
 
-	const Elf_Sym *get_symbol(const char *symbol_name) {
+	std::vector<const Elf_Sym *> get_symbols() {
 		const Elf_Shdr *s = get_section(".symtab");
-		const char *strings = get_symbol_string_table();
 
 		assert(s->sh_size % sizeof(Elf_Sym) == 0);
 
+		std::vector<const Elf_Sym *> symbols;
 		auto num_entries = s->sh_size / sizeof(typename T::Elf_Sym);
 		for (unsigned i = 0; i < num_entries; ++i) {
 			const Elf_Sym *p = reinterpret_cast<const Elf_Sym *>(elf.data() + s->sh_offset + i * sizeof(Elf_Sym));
+			symbols.push_back(p);
+		}
+
+		return symbols;
+	}
 
-			// std::cout << "check symbol: " << strings + p->st_name << std::endl;
+	const char *get_symbol_name(const Elf_Sym *symbol) {
+		return get_symbol_string_table() + symbol->st_name;
+	}
+
+	const Elf_Sym *get_symbol(const char *symbol_name) {
+		for (auto p : get_symbols()) {
+			// std::cout << "check symbol: " << get_symbol_name(p) << std::endl;
 
-			if (!strcmp(strings + p->st_name, symbol_name)) {
+			if (!strcmp(get_symbol_name(p), symbol_name)) {
 				return p;
 			}
 		}
@@ -463,6 +463,9 @@ extern std::array<const char*, NUMBER_OF_INSTRUCTIONS> mappingStr;
 Type getType(Mapping mapping);
 }  // namespace Opcode
 
+// ABI names of the integer registers, indexed by register number.
+extern const char *regnames[];
+
 #define BIT_RANGE(instr, upper, lower) (instr & (((1 << (upper - lower + 1)) - 1) << lower))
 #define BIT_SLICE(instr, upper, lower) (BIT_RANGE(instr, upper, lower) >> lower)
 #define BIT_SINGLE(instr, pos) (instr & (1 << pos))
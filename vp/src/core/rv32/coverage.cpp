@@ -15,7 +15,9 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <fstream>
+#include <stdexcept>
 
 #include "instr.h"
 #include "core_defs.h"
@@ -28,15 +30,63 @@ enum {
 	SHF_EXECINSTR = 0x04,
 };
 
+static size_t
+popcount(const std::vector<uint64_t> &bitmap)
+{
+	size_t count = 0;
+	for (auto word : bitmap)
+		count += __builtin_popcountll(word);
+	return count;
+}
+
 void
 Coverage::init(void) {
+	std::vector<const Elf32_Shdr *> sections;
+
 	// Assumption: Each executable section contains
 	// **only** RISC-V instructions. This is a heuristic
 	// which may not necessarily hold for all ELF binaries.
 	for (auto section : loader.get_sections()) {
 		if (section->sh_flags & SHF_EXECINSTR)
-			init_section(section);
+			sections.push_back(section);
 	}
+	if (sections.empty())
+		return;
+
+	// Executable sections may be far apart (e.g. ITIM, flash, and
+	// RAM on the FE310), hence only the sections themselves are
+	// mapped. Overlapping or adjacent sections are combined.
+	std::sort(sections.begin(), sections.end(), [](const Elf32_Shdr *a, const Elf32_Shdr *b) {
+		return a->sh_addr < b->sh_addr;
+	});
+
+	regions.clear();
+	last_region = 0;
+	for (auto section : sections) {
+		uint64_t base = section->sh_addr;
+		uint64_t end = base + section->sh_size;
+
+		if (!regions.empty() && base <= regions.back().end)
+			regions.back().end = std::max(regions.back().end, end);
+		else
+			regions.push_back(Region{base, end, 0});
+	}
+
+	size_t nbits = 0;
+	for (auto &region : regions) {
+		region.offset = nbits;
+		nbits += (region.end - region.base + 1) >> 1;
+	}
+
+	size_t nwords = (nbits + 63) / 64;
+	for (auto map : {&instrs, &executed_instrs, &branch_instrs, &branch_true, &branch_false})
+		map->assign(nwords, 0);
+
+	for (auto section : sections)
+		init_section(section);
+
+	total_instrs = popcount(instrs);
+	total_branches = popcount(branch_instrs) * 2;
 }
 
 void
@@ -58,79 +108,146 @@ Coverage::init_section(const Elf32_Shdr *section)
 			addr += sizeof(uint32_t);
 		}
 
-		if (parser.is_included(addr)) {
-			instrs[addr] = false;
+		size_t word;
+		uint64_t mask;
+		if (parser.is_included(last_addr) && bitmap_index(last_addr, word, mask)) {
+			instrs[word] |= mask;
 			if (instr.opcode() == Opcode::OP_BEQ)
-				branch_instrs[last_addr] = std::make_pair(false, false);
+				branch_instrs[word] |= mask;
 		}
 	}
 }
 
+/* Hit count buckets as used by AFL */
+static uint8_t
+bucket(uint8_t hits)
+{
+	if (hits <= 2)
+		return hits;
+	else if (hits == 3)
+		return 1 << 2;
+	else if (hits <= 7)
+		return 1 << 3;
+	else if (hits <= 15)
+		return 1 << 4;
+	else if (hits <= 31)
+		return 1 << 5;
+	else if (hits <= 127)
+		return 1 << 6;
+	else
+		return 1 << 7;
+}
+
+size_t
+Coverage::path_novelty(void)
+{
+	size_t novelty = 0;
+
+	for (size_t i = 0; i < EDGE_MAP_SIZE; i++) {
+		if (!edge_hits[i])
+			continue;
+
+		uint8_t b = bucket(edge_hits[i]);
+		if (!(edge_buckets[i] & b)) {
+			edge_buckets[i] |= b;
+			novelty++;
+		}
+	}
+
+	std::fill(edge_hits.begin(), edge_hits.end(), 0);
+
+	return novelty;
+}
+
+template <typename T>
+static void
+save_vector(std::ostream &stream, const std::vector<T> &vec)
+{
+	stream.write((const char *)vec.data(), vec.size() * sizeof(T));
+}
+
+template <typename T>
+static void
+load_vector(std::istream &stream, std::vector<T> &vec, bool merge)
+{
+	std::vector<T> saved(vec.size());
+	if (!stream.read((char *)saved.data(), saved.size() * sizeof(T)))
+		throw std::runtime_error("truncated coverage checkpoint");
+
+	for (size_t i = 0; i < vec.size(); i++)
+		vec[i] = (merge) ? (vec[i] | saved[i]) : saved[i];
+}
+
 void
-Coverage::cover_instr(uint64_t addr)
+Coverage::save(std::ostream &stream)
 {
-	if (!instrs.count(addr))
-		return;
+	uint64_t nregions = regions.size();
+	stream.write((const char *)&nregions, sizeof(nregions));
+	for (auto &region : regions) {
+		stream.write((const char *)&region.base, sizeof(region.base));
+		stream.write((const char *)&region.end, sizeof(region.end));
+	}
 
-	instrs[addr] = true;
+	save_vector(stream, executed_instrs);
+	save_vector(stream, branch_true);
+	save_vector(stream, branch_false);
+	save_vector(stream, edge_buckets);
 }
 
 void
-Coverage::cover_branch(uint64_t addr, bool condition)
+Coverage::load(std::istream &stream)
 {
-	if (!branch_instrs.count(addr))
-		return;
+	restore(stream, false);
+}
 
-	branch_coverage &bc = branch_instrs.at(addr);
-	if (condition)
-		bc.first = true;
-	else
-		bc.second = true;
+void
+Coverage::merge(std::istream &stream)
+{
+	restore(stream, true);
 }
 
-size_t
-Coverage::executed_branches(void)
+void
+Coverage::restore(std::istream &stream, bool merge)
 {
-	size_t executed_branches = 0;
-
-	for (auto pair : branch_instrs) {
-		branch_coverage &bc = pair.second;
-		if (bc.first)
-			executed_branches++;
-		if (bc.second)
-			executed_branches++;
+	uint64_t nregions;
+
+	if (!stream.read((char *)&nregions, sizeof(nregions)))
+		throw std::runtime_error("truncated coverage checkpoint");
+	if (nregions != regions.size())
+		throw std::runtime_error("coverage checkpoint does not match ELF binary");
+
+	for (auto &region : regions) {
+		uint64_t base, end;
+
+		if (!stream.read((char *)&base, sizeof(base)) || !stream.read((char *)&end, sizeof(end)))
+			throw std::runtime_error("truncated coverage checkpoint");
+		if (base != region.base || end != region.end)
+			throw std::runtime_error("coverage checkpoint does not match ELF binary");
 	}
 
-	return executed_branches;
+	load_vector(stream, executed_instrs, merge);
+	load_vector(stream, branch_true, merge);
+	load_vector(stream, branch_false, merge);
+	load_vector(stream, edge_buckets, merge);
+
+	num_executed_instrs = popcount(executed_instrs);
+	num_executed_branches = popcount(branch_true) + popcount(branch_false);
+}
+
+size_t
+Coverage::executed_branches(void)
+{
+	return num_executed_branches;
 }
 
 double
 Coverage::dump_branch_coverage(void)
 {
-	size_t total_branches = (branch_instrs.size() * 2);
-	size_t executed_branches = 0;
-
-	for (auto pair : branch_instrs) {
-		branch_coverage &bc = pair.second;
-		if (bc.first)
-			executed_branches++;
-		if (bc.second)
-			executed_branches++;
-	}
-
-	return (double(executed_branches) / double(total_branches)) * 100;
+	return (double(num_executed_branches) / double(total_branches)) * 100;
 }
 
 double
 Coverage::dump_instr_coverage(void)
 {
-	size_t total_instrs = instrs.size();
-	size_t executed_instrs = 0;
-
-	for (auto pair : instrs) {
-		if (pair.second)
-			executed_instrs++;
-	}
-
-	return (double(executed_instrs) / double(total_instrs)) * 100;
+	return (double(num_executed_instrs) / double(total_instrs)) * 100;
 }
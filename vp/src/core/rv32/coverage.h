@@ -18,10 +18,12 @@
 #ifndef RISCV_VP_COVERAGE_H
 #define RISCV_VP_COVERAGE_H
 
-#include <map>
+#include <algorithm>
 #include <vector>
 #include <utility>
 #include <string>
+#include <istream>
+#include <ostream>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -34,12 +36,84 @@ class Coverage {
 private:
 	ELFLoader &loader;
 
-	typedef std::pair<bool, bool> branch_coverage;
-	std::map<uint64_t, branch_coverage> branch_instrs;
+	// Bitmaps with one bit per halfword of the executable sections.
+	// Sections are stored consecutively, the bits of a section start
+	// at the offset of the corresponding region (see bitmap_index).
+	typedef std::vector<uint64_t> bitmap;
 
-	std::map<uint64_t, bool> instrs;
+	struct Region {
+		uint64_t base;
+		uint64_t end;
+		size_t offset;
+	};
+
+	// Executable address ranges, sorted by base address.
+	std::vector<Region> regions;
+	// Region of the last lookup, usually that of the next one.
+	size_t last_region = 0;
+
+	bitmap instrs;
+	bitmap executed_instrs;
+	size_t total_instrs = 0;
+	size_t num_executed_instrs = 0;
+
+	bitmap branch_instrs;
+	bitmap branch_true;
+	bitmap branch_false;
+	size_t total_branches = 0;
+	size_t num_executed_branches = 0;
+
+	// AFL-style edge coverage map for the current path. Each
+	// entry holds a saturating hit count for a hashed edge.
+	std::vector<uint8_t> edge_hits;
+	// Hit count buckets (see bucket()) seen so far for each edge.
+	std::vector<uint8_t> edge_buckets;
+
+	static inline uint32_t edge_hash(uint64_t addr) {
+		// Fibonacci hashing of the halfword address.
+		return ((uint32_t)(addr >> 1) * 0x9E3779B1U) >> (32 - EDGE_MAP_BITS);
+	}
+
+	inline bool bitmap_index(uint64_t addr, size_t &word, uint64_t &mask) {
+		if (regions.empty())
+			return false;
+
+		const Region *r = &regions[last_region];
+		if (addr < r->base || addr >= r->end) {
+			auto it = std::upper_bound(regions.begin(), regions.end(), addr,
+			                           [](uint64_t a, const Region &region) { return a < region.base; });
+			if (it == regions.begin() || addr >= (--it)->end)
+				return false;
+
+			last_region = it - regions.begin();
+			r = &*it;
+		}
+
+		uint64_t idx = r->offset + ((addr - r->base) >> 1);
+		word = idx / 64;
+		mask = (uint64_t)1 << (idx % 64);
+		return true;
+	}
+
+	void restore(std::istream &stream, bool merge);
+
+	inline bool cover(bitmap &valid, bitmap &executed, uint64_t addr) {
+		size_t word;
+		uint64_t mask;
+
+		if (!bitmap_index(addr, word, mask))
+			return false;
+		if (!(valid[word] & mask) || (executed[word] & mask))
+			return false;
+
+		executed[word] |= mask;
+		return true;
+	}
 
 public:
+	static constexpr unsigned EDGE_MAP_BITS = 16;
+	static constexpr size_t EDGE_MAP_SIZE = (size_t)1 << EDGE_MAP_BITS;
+
 	class TextAddrParser {
 	private:
 		typedef std::pair<uint64_t, uint64_t> segment;
@@ -57,15 +131,45 @@ public:
 	instr_memory_if *instr_mem = nullptr;
 
 	Coverage(ELFLoader &_loader, std::string specfile = "")
-	  : loader(_loader), parser(specfile) {
+	  : loader(_loader), edge_hits(EDGE_MAP_SIZE, 0), edge_buckets(EDGE_MAP_SIZE, 0), parser(specfile) {
 		return;
 	}
 
 	void init(void);
 	void init_section(const Elf32_Shdr *section);
 
-	void cover_instr(uint64_t);
-	void cover_branch(uint64_t, bool);
+	inline void cover_instr(uint64_t addr) {
+		if (cover(instrs, executed_instrs, addr))
+			num_executed_instrs++;
+	}
+
+	inline void cover_branch(uint64_t addr, bool condition) {
+		if (cover(branch_instrs, (condition) ? branch_true : branch_false, addr))
+			num_executed_branches++;
+	}
+
+	// Record a control flow transfer from the instruction at the
+	// given source address to the given target address.
+	inline void cover_edge(uint64_t from, uint64_t to) {
+		// Shift target to distinguish A -> B from B -> A.
+		uint8_t &hits = edge_hits[edge_hash(from) ^ (edge_hash(to) >> 1)];
+		if (hits != UINT8_MAX)
+			hits++;
+	}
+
+	// Returns the amount of edges or edge hit count buckets which
+	// were reached for the first time on the current path. Resets
+	// the edge map afterwards to prepare the next path.
+	size_t path_novelty(void);
+
+	// Save or restore the covered instructions, branches and edge
+	// buckets. Restoring requires the same ELF binary and must be
+	// performed after init().
+	void save(std::ostream &stream);
+	void load(std::istream &stream);
+
+	// Like load() but adds the saved coverage to the current one.
+	void merge(std::istream &stream);
 
 	size_t executed_branches(void);
 	double dump_branch_coverage(void);
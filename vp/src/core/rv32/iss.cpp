@@ -44,7 +44,10 @@
 // for safe down-cast
 #include <boost/lexical_cast.hpp>
 
+#include <sstream>
+
 using namespace rv32;
+using symbolic_exploration::ErrorSignature;
 
 #define RAISE_ILLEGAL_INSTRUCTION() raise_trap(EXC_ILLEGAL_INSTR, instr.data());
 
@@ -70,13 +73,6 @@ using namespace rv32;
 #define REG_ZERO solver.BVC(std::nullopt, (uint32_t)0)
 #define REG_ONE solver.BVC(std::nullopt, (uint32_t)1)
 
-const char *regnames[] = {
-    "zero (x0)", "ra   (x1)", "sp   (x2)", "gp   (x3)", "tp   (x4)", "t0   (x5)", "t1   (x6)", "t2   (x7)",
-    "s0/fp(x8)", "s1   (x9)", "a0  (x10)", "a1  (x11)", "a2  (x12)", "a3  (x13)", "a4  (x14)", "a5  (x15)",
-    "a6  (x16)", "a7  (x17)", "s2  (x18)", "s3  (x19)", "s4  (x20)", "s5  (x21)", "s6  (x22)", "s7  (x23)",
-    "s8  (x24)", "s9  (x25)", "s10 (x26)", "s11 (x27)", "t3  (x28)", "t4  (x29)", "t5  (x30)", "t6  (x31)",
-};
-
 int regcolors[] = {
 #if defined(COLOR_THEME_DARK)
     0,  1,  2,  3,  4,  5,  6,  52, 8,  9,  53, 54, 55, 56, 57, 58,
@@ -180,6 +176,12 @@ ISS::ISS(SymbolicContext &c, uint32_t hart_id, bool use_E_base_isa)
 	instr_cycles[Opcode::REM] = mul_div_cycles;
 	instr_cycles[Opcode::REMU] = mul_div_cycles;
 	op = Opcode::UNDEF;
+
+	auto &budget = symbolic_exploration::path_budget;
+	if (budget.simtime)
+		simtime_limit = sc_core::sc_time((double)budget.simtime, sc_core::SC_MS);
+	has_budget = budget.instructions || budget.simtime || budget.walltime.count();
+	start_time = std::chrono::steady_clock::now();
 }
 
 void ISS::exec_step() {
@@ -205,6 +207,11 @@ void ISS::exec_step() {
 	}
 
 	coverage->cover_instr(last_pc);
+	if (profiler) {
+		profiler->add(Profiler::INSTRUCTIONS);
+		if (has_symbolic_operands())
+			profiler->add(Profiler::SYMBOLIC_INSTRUCTIONS);
+	}
 
 	if (trace) {
 		printf("core %2u: prv %1x: pc %8x: %s ", csrs.mhartid.reg, prv, last_pc, Opcode::mappingStr[op]);
@@ -334,6 +341,14 @@ void ISS::exec_step() {
 			pc = last_pc + instr.J_imm();
 			trap_check_pc_alignment();
 			regs.write(RD, link);
+			coverage->cover_edge(last_pc, pc);
+			if (summaries && summarize())
+				break;
+			if (is_link_register(instr.rd())) {
+				push_frame(last_pc);
+				if (profiler)
+					profiler->call(pc);
+			}
 		} break;
 
 		case Opcode::JALR: {
@@ -344,6 +359,18 @@ void ISS::exec_step() {
 
 			trap_check_pc_alignment();
 			regs.write(RD, link);
+			coverage->cover_edge(last_pc, pc);
+			if (summaries && summarize())
+				break;
+			if (is_link_register(instr.rd())) {
+				push_frame(last_pc);
+				if (profiler)
+					profiler->call(pc);
+			} else if (instr.rd() == RegFile::zero && is_link_register(instr.rs1())) {
+				pop_frame(false);
+				if (profiler)
+					profiler->ret();
+			}
 		} break;
 
 		case Opcode::SB: {
@@ -1243,8 +1270,17 @@ case Opcode::LR_W: {
             if (u_mode() && csrs.misa.has_supervisor_mode_extension())
                 raise_trap(EXC_ILLEGAL_INSTR, instr.data());
 
-            if (!ignore_wfi && !has_local_pending_enabled_interrupts())
-                sc_core::wait(wfi_event);
+            if (!ignore_wfi && !has_local_pending_enabled_interrupts()) {
+                if (simtime_limit == sc_core::SC_ZERO_TIME) {
+                    sc_core::wait(wfi_event);
+                } else {
+                    // Do not wait for an interrupt beyond the simulated time budget.
+                    if (sc_core::sc_time_stamp() < simtime_limit)
+                        sc_core::wait(simtime_limit - sc_core::sc_time_stamp(), wfi_event);
+                    if (sc_core::sc_time_stamp() >= simtime_limit)
+                        symbolic_exploration::stop_hang("simulated time limit exceeded in WFI");
+                }
+            }
             break;
 
 #if 0
@@ -1735,6 +1771,10 @@ void ISS::return_from_trap_handler(PrivilegeLevel return_mode) {
 			throw std::runtime_error("unknown privilege level " + std::to_string(return_mode));
 	}
 
+	pop_frame(true);
+	if (profiler)
+		profiler->ret();
+
 	if (trace)
 		printf("[vp::iss] return from trap handler, time %s, pc %8x, prv %1x\n",
 		       quantum_keeper.get_current_time().to_string().c_str(), pc, prv);
@@ -1908,8 +1948,10 @@ void ISS::switch_to_trap_handler(PrivilegeLevel target_mode) {
 	auto pp = prv;
 	prv = target_mode;
 
+	uint32_t cause;
 	switch (target_mode) {
 		case MachineMode:
+			cause = csrs.mcause.reg;
 			csrs.mepc.reg = pc;
 
 			csrs.mstatus.mpie = csrs.mstatus.mie;
@@ -1925,6 +1967,7 @@ void ISS::switch_to_trap_handler(PrivilegeLevel target_mode) {
 		case SupervisorMode:
 			assert(prv == SupervisorMode || prv == UserMode);
 
+			cause = csrs.scause.reg;
 			csrs.sepc.reg = pc;
 
 			csrs.mstatus.spie = csrs.mstatus.sie;
@@ -1940,6 +1983,7 @@ void ISS::switch_to_trap_handler(PrivilegeLevel target_mode) {
 		case UserMode:
 			assert(prv == UserMode);
 
+			cause = csrs.ucause.reg;
 			csrs.uepc.reg = pc;
 
 			csrs.mstatus.upie = csrs.mstatus.uie;
@@ -1954,6 +1998,11 @@ void ISS::switch_to_trap_handler(PrivilegeLevel target_mode) {
 		default:
 			throw std::runtime_error("unknown privilege level " + std::to_string(target_mode));
 	}
+
+	// Trap handlers are accounted like called functions.
+	push_frame(last_pc, cause);
+	if (profiler)
+		profiler->call(pc);
 }
 
 void ISS::performance_and_sync_update(Opcode::Mapping executed_op) {
@@ -1981,6 +2030,119 @@ void ISS::performance_and_sync_update(Opcode::Mapping executed_op) {
 	}
 }
 
+bool ISS::has_symbolic_operands() {
+	switch (Opcode::getType(op)) {
+		case Opcode::Type::R:
+		case Opcode::Type::S:
+		case Opcode::Type::B:
+			return regs[instr.rs1()]->symbolic.has_value() || regs[instr.rs2()]->symbolic.has_value();
+		case Opcode::Type::I:
+			return regs[instr.rs1()]->symbolic.has_value();
+		default:
+			return false;
+	}
+}
+
+void ISS::check_budget() {
+	auto &budget = symbolic_exploration::path_budget;
+	if (budget.instructions && total_num_instr >= budget.instructions)
+		symbolic_exploration::stop_hang("instruction limit exceeded");
+
+	// Querying the time is comparatively expensive, only do so periodically.
+	if (total_num_instr % 1024)
+		return;
+
+	if (simtime_limit != sc_core::SC_ZERO_TIME && quantum_keeper.get_current_time() >= simtime_limit)
+		symbolic_exploration::stop_hang("simulated time limit exceeded");
+	if (budget.walltime.count() && std::chrono::steady_clock::now() - start_time >= budget.walltime)
+		symbolic_exploration::stop_hang("wall time limit exceeded");
+}
+
+void ISS::detect_loop() {
+	// While an interrupt can still be taken, an unchanged register state
+	// does not imply a hang (e.g. busy-waiting on a flag set by an
+	// interrupt handler). Only loops with interrupts disabled are detected.
+	if (csrs.mie.reg && (prv < MachineMode || csrs.mstatus.mie)) {
+		loop_count = 0;
+		return;
+	}
+
+	size_t hash = 0;
+	for (unsigned i = 1; i < RegFile::NUM_REGS; i++)
+		hash = hash * 31 + solver.getValue<uint32_t>(regs[i]->concrete);
+
+	if (pc != loop_pc || hash != loop_hash) {
+		loop_pc = pc;
+		loop_hash = hash;
+		loop_count = 0;
+	} else if (++loop_count >= symbolic_exploration::path_budget.loops) {
+		std::ostringstream msg;
+		msg << "loop without progress at pc 0x" << std::hex << pc;
+		symbolic_exploration::stop_hang(msg.str());
+	}
+}
+
+void ISS::push_frame(uint32_t call_site, uint32_t cause) {
+	if (shadow_stack.size() >= MAX_SHADOW_STACK) {
+		shadow_overflow++;
+		return;
+	}
+
+	shadow_stack.push_back(Frame{call_site, cause});
+}
+
+void ISS::pop_frame(bool trap) {
+	if (shadow_overflow > 0) {
+		shadow_overflow--;
+		return;
+	}
+
+	// Frames of functions which did not return regularly (e.g. due to
+	// a longjmp in the trap handler) are discarded on trap return.
+	while (!shadow_stack.empty()) {
+		bool is_trap = shadow_stack.back().cause != ErrorSignature::NO_TRAP;
+		shadow_stack.pop_back();
+		if (!trap || is_trap)
+			break;
+	}
+}
+
+bool ISS::summarize() {
+	if (!summaries->run(*this, pc))
+		return false;
+
+	// Tail calls do not link, the function returns to our caller.
+	auto link = is_link_register(instr.rd()) ? instr.rd() : (uint32_t)RegFile::ra;
+	pc = solver.getValue<uint32_t>(regs[link]->concrete);
+	return true;
+}
+
+ErrorSignature ISS::error_signature() {
+	ErrorSignature signature;
+	signature.pc = last_pc;
+
+	// FNV-1a hash of the call sites on the shadow stack.
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (auto &frame : shadow_stack) {
+		hash = (hash ^ frame.call_site) * 0x100000001b3ULL;
+		if (frame.cause != ErrorSignature::NO_TRAP)
+			signature.cause = frame.cause;
+	}
+	signature.stack = hash;
+
+	return signature;
+}
+
+void ISS::record_trace() {
+	uint32_t symbolic = 0;
+	for (unsigned i = 0; i < RegFile::NUM_REGS; i++) {
+		if (regs[i]->symbolic.has_value())
+			symbolic |= 1U << i;
+	}
+
+	trace_ring->record(last_pc, instr.data(), solver.getValue<uint32_t>(regs[instr.rd()]->concrete), symbolic);
+}
+
 void ISS::run_step() {
 	assert(solver.getValue<uint32_t>(regs.read(0)->concrete) == 0);
 
@@ -2012,6 +2174,14 @@ void ISS::run_step() {
 	// before every register write)
 	regs.write(regs.zero, solver.BVC(std::nullopt, (uint32_t)0));
 
+	if (trace_ring)
+		record_trace();
+
+	// Traps usually also jump backwards, thereby resetting the loop
+	// detection if an interrupt is taken in a loop.
+	if (symbolic_exploration::path_budget.loops && pc <= last_pc)
+		detect_loop();
+
 	// Do not use a check *pc == last_pc* here. The reason is that due to
 	// interrupts *pc* can be set to *last_pc* accidentally (when jumping back
 	// to *mepc*).
@@ -2019,9 +2189,15 @@ void ISS::run_step() {
 		status = CoreExecStatus::Terminated;
 
 	performance_and_sync_update(op);
+	if (has_budget)
+		check_budget();
 }
 
 void ISS::run() {
+	// The elaborated platform may be forked for each test case (see
+	// symbolic_exploration::fork_server), start the wall time budget here.
+	start_time = std::chrono::steady_clock::now();
+
 	// run a single step until either a breakpoint is hit or the execution
 	// terminates
 	do {
@@ -53,11 +53,16 @@
 #include "symbolic_context.h"
 #include "util/common.h"
 #include "coverage.h"
+#include "profiler.h"
+#include "summaries.h"
+#include "trace_ring.h"
+#include "symbolic_explore.h"
 
 #include <assert.h>
 #include <stdint.h>
 #include <string.h>
 
+#include <chrono>
 #include <functional>
 #include <iostream>
 #include <map>
@@ -219,6 +224,9 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
 	int64_t lr_sc_counter = 0;
 	uint64_t total_num_instr = 0;
 	Coverage *coverage = nullptr;
+	Profiler *profiler = nullptr;
+	TraceRing *trace_ring = nullptr;
+	Summaries *summaries = nullptr;
 
 	// last decoded and executed instruction and opcode
 	Instruction instr;
@@ -230,6 +238,26 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
 
 	sc_core::sc_event wfi_event;
 
+	// Execution budget of the current path (see PathBudget).
+	bool has_budget = false;
+	sc_core::sc_time simtime_limit = sc_core::SC_ZERO_TIME;
+	std::chrono::steady_clock::time_point start_time;
+
+	// Shadow call stack of the software, maintained using the same
+	// heuristics as the Profiler (see error_signature).
+	struct Frame {
+		uint32_t call_site; // Call instruction or interrupted instruction
+		uint32_t cause;     // Trap cause, NO_TRAP for function calls
+	};
+	static constexpr size_t MAX_SHADOW_STACK = 256;
+	std::vector<Frame> shadow_stack;
+	unsigned shadow_overflow = 0;
+
+	// Backward jump target and register state last observed there.
+	uint32_t loop_pc = 0;
+	size_t loop_hash = 0;
+	unsigned loop_count = 0;
+
 	std::string systemc_name;
 	tlm_utils::tlm_quantumkeeper quantum_keeper;
 	sc_core::sc_time cycle_time;
@@ -243,6 +271,32 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
 
 	void exec_step();
 
+	// True if a source register of the current instruction is symbolic.
+	bool has_symbolic_operands();
+
+	// Append the last executed instruction to the trace ring.
+	void record_trace();
+
+	void push_frame(uint32_t call_site, uint32_t cause = symbolic_exploration::ErrorSignature::NO_TRAP);
+	void pop_frame(bool trap);
+
+	// Terminate the path if its execution budget is exhausted.
+	void check_budget();
+
+	// Terminate the path if the register state at a backward jump
+	// target recurs too often, i.e. if a concrete loop does not make
+	// progress.
+	void detect_loop();
+
+	// Execute the summary of the function jumped to, if any, and
+	// return to the caller (see Summaries).
+	bool summarize();
+
+	// Registers used for return addresses by the calling convention.
+	static bool is_link_register(uint32_t reg) {
+		return reg == RegFile::x1 || reg == RegFile::x5;
+	}
+
 	uint64_t _compute_and_get_current_cycles();
 
 	void init(instr_memory_if *instr_mem, data_memory_if *data_mem, clint_if *clint, uint32_t entrypoint, uint32_t sp);
@@ -258,6 +312,7 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
 
 	void sys_processed_packet() override;
 	void sys_exit() override;
+	symbolic_exploration::ErrorSignature error_signature() override;
 	unsigned get_syscall_register_index() override;
 	uint64_t read_register(unsigned idx) override;
 	void write_register(unsigned idx, uint64_t value) override;
@@ -265,16 +320,34 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
     std::vector<uint64_t> get_registers(void) override;
 
     bool eval(std::shared_ptr<clover::BitVector> bv) {
+        // Concrete values are constants and do not require a query.
+        auto ce = klee::dyn_cast<klee::ConstantExpr>(bv->expr);
+        if (ce)
+            return ce->isTrue();
+
         auto q = tracer.getQuery(bv);
-        return solver.eval(q);
+        if (!profiler)
+            return solver.eval(q);
+
+        auto start = Profiler::clock::now();
+        bool result = solver.eval(q);
+        profiler->add_solver_time(Profiler::clock::now() - start);
+        return result;
     };
 
     void track_and_trace_branch(bool cond, std::shared_ptr<clover::ConcolicValue> expr) {
-        if (coverage)
+        if (coverage) {
             coverage->cover_branch(last_pc, cond);
+            // Instructions are at least 2-byte aligned, use the lowest bit
+            // to distinguish conditions that do not alter the control flow.
+            coverage->cover_edge(last_pc, pc | cond);
+        }
 
-        if (expr->symbolic.has_value())
+        if (expr->symbolic.has_value()) {
             tracer.add(cond, *expr->symbolic, last_pc, symbolic_context.current_index() + 1);
+            if (profiler)
+                profiler->add(Profiler::BRANCHES);
+        }
     };
 
     void make_symbolic(uint32_t addr, size_t size) override {
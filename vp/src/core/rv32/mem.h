@@ -43,6 +43,7 @@
 #include "iss.h"
 #include "mmu.h"
 #include "symbolic_extension.h"
+#include "symbolic_dmi.h"
 
 namespace rv32 {
 
@@ -77,6 +78,11 @@ struct CombinedMemoryInterface : public sc_core::sc_module,
 	sc_core::sc_time clock_cycle = sc_core::sc_time(10, sc_core::SC_NS);
 	sc_core::sc_time dmi_access_delay = clock_cycle * 4;
 	std::vector<MemoryDMI> dmi_ranges;
+	// DMI ranges of memories which may contain symbolic values
+	std::vector<SymbolicMemoryDMI> symbolic_dmi_ranges;
+	// Maximum size of symbolic accesses performed via DMI, larger
+	// accesses (e.g. by make_symbolic) are performed through TLM.
+	static constexpr size_t MAX_DMI_ACCESS_SIZE = 64;
 
     MMU *mmu;
 
@@ -167,6 +173,15 @@ struct CombinedMemoryInterface : public sc_core::sc_module,
 			}
 		}
 
+		// The concrete part of symbolic bytes is also stored in
+		// the DMI page, hence the shadow bitmap need not be checked.
+		for (auto &e : symbolic_dmi_ranges) {
+			if (e.contains(addr, sizeof(T))) {
+				quantum_keeper.inc(dmi_access_delay);
+				return e.get_concrete_dmi().load<T>(addr);
+			}
+		}
+
 		T ans;
 		_do_transaction(tlm::TLM_READ_COMMAND, addr, (uint8_t *)&ans, sizeof(T));
 		return ans;
@@ -184,32 +199,101 @@ struct CombinedMemoryInterface : public sc_core::sc_module,
 				done = true;
 			}
 		}
+		for (auto &e : symbolic_dmi_ranges) {
+			if (e.contains(addr, sizeof(T))) {
+				quantum_keeper.inc(dmi_access_delay);
+				e.store(addr, (uint8_t *)&value, sizeof(T));
+				done = true;
+			}
+		}
 
 		if (!done)
 			_do_transaction(tlm::TLM_WRITE_COMMAND, addr, (uint8_t *)&value, sizeof(T));
 		atomic_unlock();
 	}
 
+	bool symbolic_dmi_store(uint64_t addr, Concolic data, size_t num_bytes) {
+		uint8_t buf[MAX_DMI_ACCESS_SIZE];
+		if (num_bytes > sizeof(buf))
+			return false;
+
+		// Memories in dmi_ranges only store concrete values.
+		for (auto &e : dmi_ranges) {
+			if (e.contains(addr) && e.contains(addr + num_bytes - 1)) {
+				quantum_keeper.inc(dmi_access_delay);
+				iss.solver.BVCToBytes(data, &buf[0], num_bytes);
+				memcpy(e.get_mem_ptr_to_global_addr<uint8_t>(addr), &buf[0], num_bytes);
+				return true;
+			}
+		}
+
+		// Symbolic values must be stored through TLM, thereby
+		// allowing the memory to track the symbolic part.
+		if (data->symbolic.has_value())
+			return false;
+
+		for (auto &e : symbolic_dmi_ranges) {
+			if (e.contains(addr, num_bytes)) {
+				quantum_keeper.inc(dmi_access_delay);
+				iss.solver.BVCToBytes(data, &buf[0], num_bytes);
+				e.store(addr, &buf[0], num_bytes);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool symbolic_dmi_load(uint64_t addr, Concolic &data, size_t num_bytes) {
+		uint8_t buf[MAX_DMI_ACCESS_SIZE];
+		if (num_bytes > sizeof(buf))
+			return false;
+
+		for (auto &e : dmi_ranges) {
+			if (e.contains(addr) && e.contains(addr + num_bytes - 1)) {
+				quantum_keeper.inc(dmi_access_delay);
+				memcpy(&buf[0], e.get_mem_ptr_to_global_addr<uint8_t>(addr), num_bytes);
+				data = iss.solver.BVC(&buf[0], num_bytes);
+				return true;
+			}
+		}
+
+		for (auto &e : symbolic_dmi_ranges) {
+			if (e.contains(addr, num_bytes)) {
+				// Fall back to TLM if any byte is symbolic.
+				if (!e.is_concrete(addr, num_bytes))
+					return false;
+
+				quantum_keeper.inc(dmi_access_delay);
+				e.load(addr, &buf[0], num_bytes);
+				data = iss.solver.BVC(&buf[0], num_bytes);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
 	void symbolic_store_data(Concolic addr, Concolic data, size_t num_bytes) override {
 		bus_lock->wait_for_access_rights(iss.get_hart_id());
-		// XXX: DMI is currently not supported for symbolic values.
 
 		auto caddr = iss.solver.getValue<uint32_t>(addr->concrete);
 		auto vaddr = v2p(caddr, STORE);
 
-		_do_transaction(tlm::TLM_WRITE_COMMAND, vaddr, data, num_bytes);
+		if (!symbolic_dmi_store(vaddr, data, num_bytes))
+			_do_transaction(tlm::TLM_WRITE_COMMAND, vaddr, data, num_bytes);
 		atomic_unlock();
 	}
 
 	Concolic symbolic_load_data(Concolic addr, size_t num_bytes) override {
 		bus_lock->wait_for_access_rights(iss.get_hart_id());
-		// XXX: DMI is currently not supported for symbolic values.
 
 		auto caddr = iss.solver.getValue<uint32_t>(addr->concrete);
 		auto vaddr = v2p(caddr, STORE);
 
 		Concolic data;
-		_do_transaction(tlm::TLM_READ_COMMAND, vaddr, data, num_bytes);
+		if (!symbolic_dmi_load(vaddr, data, num_bytes))
+			_do_transaction(tlm::TLM_READ_COMMAND, vaddr, data, num_bytes);
 		return data;
 	}
 
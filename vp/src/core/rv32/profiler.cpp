@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2022 Group of Computer Architecture, University of Bremen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "profiler.h"
+
+using namespace rv32;
+
+/* Symbol type of functions in ELF symbol table */
+enum {
+	STT_FUNC = 0x02,
+};
+
+#define ELF32_ST_TYPE(INFO) ((INFO) & 0xf)
+
+/* Maximum depth of reconstructed call stacks */
+#define MAX_DEPTH 256
+
+static const char *metric_names[Profiler::METRIC_COUNT] = {
+	"instructions",
+	"symbolic",
+	"branches",
+	"solver",
+};
+
+Profiler::Profiler(ELFLoader &loader, std::string _prefix)
+  : prefix(_prefix)
+{
+	for (auto sym : loader.get_symbols()) {
+		if (ELF32_ST_TYPE(sym->st_info) != STT_FUNC)
+			continue;
+		symbols.push_back(Symbol{sym->st_value, sym->st_size, loader.get_symbol_name(sym)});
+	}
+
+	std::sort(symbols.begin(), symbols.end(), [](const Symbol &a, const Symbol &b) {
+		return a.addr < b.addr;
+	});
+
+	nodes.push_back(Node(loader.get_entrypoint(), 0, 0));
+}
+
+void
+Profiler::reset(void)
+{
+	current = 0;
+	overflow = 0;
+}
+
+void
+Profiler::call(uint32_t addr)
+{
+	if (nodes[current].depth >= MAX_DEPTH) {
+		overflow++;
+		return;
+	}
+
+	auto it = nodes[current].children.find(addr);
+	if (it != nodes[current].children.end()) {
+		current = it->second;
+		return;
+	}
+
+	size_t child = nodes.size();
+	nodes.push_back(Node(addr, current, nodes[current].depth + 1));
+	nodes[current].children[addr] = child;
+	current = child;
+}
+
+std::string
+Profiler::symbolize(uint32_t addr)
+{
+	// Find last symbol starting at or before the given address.
+	auto it = std::upper_bound(symbols.begin(), symbols.end(), addr, [](uint32_t addr, const Symbol &sym) {
+		return addr < sym.addr;
+	});
+
+	if (it != symbols.begin()) {
+		auto &sym = *(--it);
+		if (sym.addr == addr || addr - sym.addr < sym.size)
+			return sym.name;
+	}
+
+	std::ostringstream stream;
+	stream << "0x" << std::hex << addr;
+	return stream.str();
+}
+
+void
+Profiler::write(std::ostream &stream, size_t node, const std::string &stack, Metric metric)
+{
+	auto &n = nodes[node];
+	auto name = (stack.empty()) ? symbolize(n.func) : stack + ";" + symbolize(n.func);
+
+	if (n.values[metric])
+		stream << name << " " << n.values[metric] << "\n";
+	for (auto &child : n.children)
+		write(stream, child.second, name, metric);
+}
+
+void
+Profiler::dump(void)
+{
+	for (size_t i = 0; i < METRIC_COUNT; i++) {
+		auto path = prefix + "." + metric_names[i] + ".folded";
+
+		std::ofstream file(path);
+		if (!file.is_open())
+			throw std::runtime_error("failed to open " + path);
+		write(file, 0, "", (Metric)i);
+	}
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2022 Group of Computer Architecture, University of Bremen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RISCV_VP_PROFILER_H
+#define RISCV_VP_PROFILER_H
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+#include "elf_loader.h"
+
+namespace rv32 {
+
+// Attributes the cost of the executed software to its call stacks.
+// Call stacks are reconstructed from calls and returns as defined by
+// the RISC-V calling convention (i.e. jumps which link to ra or t0),
+// trap handlers are treated like functions called at the trap entry.
+// The profile is accumulated across all explored paths and written as
+// folded stacks, one file per metric, which can be passed to flame
+// graph tools directly.
+class Profiler {
+public:
+	typedef std::chrono::steady_clock clock;
+
+	enum Metric {
+		INSTRUCTIONS,          // Executed instructions
+		SYMBOLIC_INSTRUCTIONS, // Instructions with symbolic operands
+		BRANCHES,              // Branches added to the execution tree
+		SOLVER_TIME,           // Solver time during execution (µs)
+		METRIC_COUNT,
+	};
+
+private:
+	// Node of the calling context tree, identified by the address
+	// of the called function and the calling context.
+	struct Node {
+		uint32_t func;
+		size_t parent;
+		unsigned depth;
+		std::unordered_map<uint32_t, size_t> children;
+		uint64_t values[METRIC_COUNT] = {};
+
+		Node(uint32_t _func, size_t _parent, unsigned _depth)
+		  : func(_func), parent(_parent), depth(_depth) {}
+	};
+
+	// Function symbols sorted by address.
+	struct Symbol {
+		uint32_t addr;
+		uint32_t size;
+		std::string name;
+	};
+
+	std::string prefix;
+	std::vector<Symbol> symbols;
+
+	std::vector<Node> nodes;
+	size_t current = 0;
+
+	// Calls exceeding the maximum stack depth (e.g. due to deep
+	// recursion) are accounted to the deepest node.
+	unsigned overflow = 0;
+
+	std::string symbolize(uint32_t addr);
+	void write(std::ostream &stream, size_t node, const std::string &stack, Metric metric);
+
+public:
+	// Profiles are written to <prefix>.<metric>.folded.
+	Profiler(ELFLoader &loader, std::string _prefix);
+
+	// Start a new path, the stack is reset to the entry point.
+	void reset(void);
+
+	inline void add(Metric metric, uint64_t value = 1) {
+		nodes[current].values[metric] += value;
+	}
+
+	inline void add_solver_time(clock::duration duration) {
+		add(SOLVER_TIME, std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+	}
+
+	// Enter the function at the given address.
+	void call(uint32_t addr);
+
+	// Return to the calling function.
+	inline void ret(void) {
+		if (overflow > 0)
+			overflow--;
+		else if (current != 0)
+			current = nodes[current].parent;
+	}
+
+	void dump(void);
+};
+
+}
+
+#endif
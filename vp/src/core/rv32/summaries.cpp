@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2022 Group of Computer Architecture, University of Bremen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <assert.h>
+
+#include "iss.h"
+#include "summaries.h"
+
+using namespace rv32;
+
+typedef std::shared_ptr<clover::ConcolicValue> Concolic;
+
+/* Symbol type of functions in ELF symbol table */
+enum {
+	STT_FUNC = 0x02,
+};
+
+#define ELF32_ST_TYPE(INFO) ((INFO) & 0xf)
+
+/* Maximum length of strings and compared memory regions, longer ones
+ * are processed by executing the function, and maximum size of single
+ * memory accesses. */
+#define MAX_STRING_LENGTH 4096
+#define MAX_CHUNK_SIZE 64
+
+static const std::unordered_map<std::string, Summaries::Function> names = {
+	{"memcpy", Summaries::MEMCPY},
+	{"memmove", Summaries::MEMMOVE},
+	{"memset", Summaries::MEMSET},
+	{"memcmp", Summaries::MEMCMP},
+	{"bcmp", Summaries::MEMCMP},
+	{"strlen", Summaries::STRLEN},
+	{"strnlen", Summaries::STRNLEN},
+	{"strcmp", Summaries::STRCMP},
+	{"strncmp", Summaries::STRNCMP},
+
+	// String functions of RIOT's fmt module
+	{"fmt_strlen", Summaries::STRLEN},
+	{"fmt_strnlen", Summaries::STRNLEN},
+};
+
+Summaries::Summaries(ELFLoader &loader)
+{
+	for (auto sym : loader.get_symbols()) {
+		if (ELF32_ST_TYPE(sym->st_info) != STT_FUNC)
+			continue;
+
+		auto it = names.find(loader.get_symbol_name(sym));
+		if (it != names.end())
+			functions[sym->st_value] = it->second;
+	}
+}
+
+static bool
+is_concrete(ISS &iss, std::initializer_list<uint32_t> args)
+{
+	return std::none_of(args.begin(), args.end(), [&iss](uint32_t reg) {
+		return iss.regs[reg]->symbolic.has_value();
+	});
+}
+
+static uint32_t
+get_arg(ISS &iss, uint32_t reg)
+{
+	return iss.solver.getValue<uint32_t>(iss.regs[reg]->concrete);
+}
+
+static Concolic
+load(ISS &iss, uint32_t addr, size_t size = 1)
+{
+	return iss.mem->symbolic_load_data(iss.solver.BVC(std::nullopt, addr), size);
+}
+
+static void
+store(ISS &iss, uint32_t addr, Concolic value, size_t size)
+{
+	iss.mem->symbolic_store_data(iss.solver.BVC(std::nullopt, addr), value, size);
+}
+
+/* Conjunction of the given condition with the previous ones, constant
+ * conditions hold on the current path and are omitted. */
+static void
+conjoin(Concolic &cond, Concolic value)
+{
+	if (!value->symbolic.has_value())
+		return;
+	cond = (cond) ? cond->band(value) : value;
+}
+
+/* Add the condition to the path, like a branch taken by the software */
+static void
+constrain(ISS &iss, Concolic cond)
+{
+	if (!cond)
+		return;
+
+	assert(iss.solver.getValue<bool>(cond->concrete));
+	iss.tracer.add(true, *cond->symbolic, iss.last_pc, symbolic_context.current_index() + 1);
+	if (iss.profiler)
+		iss.profiler->add(Profiler::BRANCHES);
+}
+
+static void
+copy(ISS &iss, uint32_t dest, uint32_t src, uint32_t n)
+{
+	// Overlapping regions with dest after src are copied backwards.
+	bool backwards = dest > src && dest - src < n;
+
+	for (uint32_t done = 0; done < n;) {
+		uint32_t size = std::min(n - done, (uint32_t)MAX_CHUNK_SIZE);
+		uint32_t off = (backwards) ? n - done - size : done;
+
+		store(iss, dest + off, load(iss, src + off, size), size);
+		done += size;
+	}
+}
+
+static void
+fill(ISS &iss, uint32_t dest, Concolic byte, uint32_t n)
+{
+	Concolic chunk = byte;
+	for (size_t i = 1; i < std::min(n, (uint32_t)MAX_CHUNK_SIZE); i++)
+		chunk = byte->concat(chunk);
+
+	for (uint32_t off = 0; off < n; off += MAX_CHUNK_SIZE) {
+		uint32_t size = std::min(n - off, (uint32_t)MAX_CHUNK_SIZE);
+		store(iss, dest + off, (size < MAX_CHUNK_SIZE) ? chunk->extract(0, size * 8) : chunk, size);
+	}
+}
+
+/* Returns the length of the string, or -1 if it exceeds the maximum */
+static int64_t
+length(ISS &iss, uint32_t str, uint32_t maxlen)
+{
+	auto zero = iss.solver.BVC(std::nullopt, (uint8_t)0);
+
+	Concolic cond = nullptr;
+	for (uint32_t len = 0; len < std::min(maxlen, (uint32_t)MAX_STRING_LENGTH); len++) {
+		auto c = load(iss, str + len);
+		if (iss.solver.getValue<uint8_t>(c->concrete) == 0) {
+			conjoin(cond, c->eq(zero));
+			constrain(iss, cond);
+			return len;
+		}
+
+		conjoin(cond, c->ne(zero));
+	}
+
+	if (maxlen > MAX_STRING_LENGTH)
+		return -1;
+
+	constrain(iss, cond);
+	return maxlen;
+}
+
+/* Compares up to n bytes, stopping at the first null byte if strings
+ * are compared. Returns the difference of the first distinct bytes, or
+ * std::nullopt if more than MAX_STRING_LENGTH bytes are equal. */
+static std::optional<Concolic>
+compare(ISS &iss, uint32_t s1, uint32_t s2, uint32_t n, bool strings)
+{
+	if (n > MAX_STRING_LENGTH)
+		n = MAX_STRING_LENGTH + 1;
+
+	auto zero = iss.solver.BVC(std::nullopt, (uint8_t)0);
+
+	// Equality of all bytes before the first distinct one is
+	// expressed as a single comparison of the concatenated bytes.
+	Concolic prefix1 = nullptr, prefix2 = nullptr, cond = nullptr;
+	for (uint32_t i = 0; i < n; i++) {
+		if (i == MAX_STRING_LENGTH)
+			return std::nullopt;
+
+		auto c1 = load(iss, s1 + i);
+		auto c2 = load(iss, s2 + i);
+
+		auto v1 = iss.solver.getValue<uint8_t>(c1->concrete);
+		auto v2 = iss.solver.getValue<uint8_t>(c2->concrete);
+		if (v1 != v2 || (strings && v1 == 0)) {
+			if (prefix1)
+				conjoin(cond, prefix1->eq(prefix2));
+			if (v1 != v2)
+				conjoin(cond, c1->ne(c2));
+			else
+				conjoin(cond, c1->eq(zero)->band(c2->eq(zero)));
+
+			constrain(iss, cond);
+			return c1->zext(32)->sub(c2->zext(32));
+		}
+
+		prefix1 = (prefix1) ? c1->concat(prefix1) : c1;
+		prefix2 = (prefix2) ? c2->concat(prefix2) : c2;
+		if (strings)
+			conjoin(cond, c1->ne(zero));
+	}
+
+	if (prefix1)
+		conjoin(cond, prefix1->eq(prefix2));
+	constrain(iss, cond);
+	return iss.solver.BVC(std::nullopt, (uint32_t)0);
+}
+
+bool
+Summaries::run(ISS &iss, uint32_t addr)
+{
+	auto it = functions.find(addr);
+	if (it == functions.end())
+		return false;
+
+	switch (it->second) {
+	case MEMCPY:
+	case MEMMOVE:
+		if (!is_concrete(iss, {RegFile::a0, RegFile::a1, RegFile::a2}))
+			return false;
+
+		// Copying overlapping regions is undefined for memcpy,
+		// copy these regions like memmove.
+		copy(iss, get_arg(iss, RegFile::a0), get_arg(iss, RegFile::a1), get_arg(iss, RegFile::a2));
+		break;
+	case MEMSET:
+		if (!is_concrete(iss, {RegFile::a0, RegFile::a2}))
+			return false;
+
+		fill(iss, get_arg(iss, RegFile::a0), iss.regs[RegFile::a1]->extract(0, 8), get_arg(iss, RegFile::a2));
+		break;
+	case MEMCMP:
+	case STRCMP:
+	case STRNCMP: {
+		bool strings = it->second != MEMCMP;
+		if (!is_concrete(iss, {RegFile::a0, RegFile::a1}))
+			return false;
+
+		uint32_t n = UINT32_MAX;
+		if (it->second != STRCMP) {
+			if (!is_concrete(iss, {RegFile::a2}))
+				return false;
+			n = get_arg(iss, RegFile::a2);
+		}
+
+		auto result = compare(iss, get_arg(iss, RegFile::a0), get_arg(iss, RegFile::a1), n, strings);
+		if (!result.has_value())
+			return false;
+		iss.regs.write(RegFile::a0, *result);
+	} break;
+	case STRLEN:
+	case STRNLEN: {
+		if (!is_concrete(iss, {RegFile::a0}))
+			return false;
+
+		uint32_t maxlen = UINT32_MAX;
+		if (it->second == STRNLEN) {
+			if (!is_concrete(iss, {RegFile::a1}))
+				return false;
+			maxlen = get_arg(iss, RegFile::a1);
+		}
+
+		auto len = length(iss, get_arg(iss, RegFile::a0), maxlen);
+		if (len < 0)
+			return false;
+		iss.regs.write(RegFile::a0, iss.solver.BVC(std::nullopt, (uint32_t)len));
+	} break;
+	}
+
+	return true;
+}
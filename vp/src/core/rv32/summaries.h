@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2022 Group of Computer Architecture, University of Bremen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RISCV_VP_SUMMARIES_H
+#define RISCV_VP_SUMMARIES_H
+
+#include <unordered_map>
+#include <stdint.h>
+
+#include "elf_loader.h"
+
+namespace rv32 {
+
+struct ISS;
+
+// Summaries of C library functions (e.g. memcmp or strlen) which
+// process memory in byte loops. Executing these functions adds a
+// branch to the execution tree for each symbolic byte. Instead, the
+// functions are identified by their ELF symbol and, when called,
+// executed natively on the memory of the ISS. Only a single constraint,
+// which describes the computed result, is added to the path.
+class Summaries {
+public:
+	enum Function {
+		MEMCPY,
+		MEMMOVE,
+		MEMSET,
+		MEMCMP,
+		STRLEN,
+		STRNLEN,
+		STRCMP,
+		STRNCMP,
+	};
+
+private:
+	// Summarized functions by address of their first instruction.
+	std::unordered_map<uint32_t, Function> functions;
+
+public:
+	Summaries(ELFLoader &loader);
+
+	// Execute the summary of the function at the given address, if
+	// any. Arguments and result are passed as defined by the calling
+	// convention. Returns false if the function must be executed
+	// instead, e.g. if a length or pointer argument is symbolic.
+	bool run(ISS &iss, uint32_t addr);
+};
+
+}
+
+#endif
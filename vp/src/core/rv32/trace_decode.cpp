@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2022 Group of Computer Architecture, University of Bremen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Renders an instruction trace written by the TraceRing (see the
+// --trace-ring option of the VPs) in the format of --trace-mode.
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "core/common/instr.h"
+#include "trace_ring.h"
+
+using namespace rv32;
+
+static void
+print_operands(Instruction instr, Opcode::Mapping op)
+{
+	switch (Opcode::getType(op)) {
+	case Opcode::Type::R:
+		printf(" %s, %s, %s", regnames[instr.rd()], regnames[instr.rs1()], regnames[instr.rs2()]);
+		break;
+	case Opcode::Type::I:
+		printf(" %s, %s, 0x%x", regnames[instr.rd()], regnames[instr.rs1()], instr.I_imm());
+		break;
+	case Opcode::Type::S:
+		printf(" %s, %s, 0x%x", regnames[instr.rs1()], regnames[instr.rs2()], instr.S_imm());
+		break;
+	case Opcode::Type::B:
+		printf(" %s, %s, 0x%x", regnames[instr.rs1()], regnames[instr.rs2()], instr.B_imm());
+		break;
+	case Opcode::Type::U:
+		printf(" %s, 0x%x", regnames[instr.rd()], instr.U_imm());
+		break;
+	case Opcode::Type::J:
+		printf(" %s, 0x%x", regnames[instr.rd()], instr.J_imm());
+		break;
+	default:;
+	}
+}
+
+static bool
+writes_rd(Opcode::Mapping op)
+{
+	switch (Opcode::getType(op)) {
+	case Opcode::Type::R:
+	case Opcode::Type::I:
+	case Opcode::Type::U:
+	case Opcode::Type::J:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void
+print_record(const TraceRing::Record &rec)
+{
+	Instruction instr(rec.instr);
+	auto op = instr.decode_normal(RV32);
+
+	printf("pc %8x: %s", rec.pc, Opcode::mappingStr[op]);
+	print_operands(instr, op);
+	if (writes_rd(op) && instr.rd() != 0)
+		printf(" [%s = 0x%x]", regnames[instr.rd()], rec.rd_value);
+
+	if (rec.symbolic) {
+		printf(" symbolic:");
+		for (unsigned i = 0; i < 32; i++) {
+			if (rec.symbolic & (1U << i))
+				printf(" %s", regnames[i]);
+		}
+	}
+	puts("");
+}
+
+static std::vector<TraceRing::Record>
+load_trace(const char *path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		err(EXIT_FAILURE, "%s", path);
+
+	char magic[sizeof(TraceRing::MAGIC)];
+	if (!file.read(magic, sizeof(magic)) || memcmp(magic, TraceRing::MAGIC, sizeof(magic)))
+		errx(EXIT_FAILURE, "%s: not an instruction trace", path);
+
+	uint64_t count;
+	if (!file.read((char *)&count, sizeof(count)))
+		errx(EXIT_FAILURE, "%s: truncated header", path);
+
+	std::vector<TraceRing::Record> records(count);
+	if (!file.read((char *)records.data(), count * sizeof(TraceRing::Record)))
+		errx(EXIT_FAILURE, "%s: truncated trace, expected %llu records", path, (unsigned long long)count);
+
+	return records;
+}
+
+static void
+usage(const char *progname)
+{
+	std::cerr << "USAGE: " << progname << " [-n COUNT] TRACE" << std::endl;
+	exit(EXIT_FAILURE);
+}
+
+int
+main(int argc, char **argv)
+{
+	size_t last = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:")) != -1) {
+		switch (opt) {
+		case 'n':
+			last = strtoul(optarg, NULL, 10);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	if (argc - optind != 1)
+		usage(argv[0]);
+
+	// Only print the last COUNT records if specified.
+	auto records = load_trace(argv[optind]);
+	size_t start = (last > 0 && last < records.size()) ? records.size() - last : 0;
+
+	for (size_t i = start; i < records.size(); i++)
+		print_record(records[i]);
+
+	return EXIT_SUCCESS;
+}
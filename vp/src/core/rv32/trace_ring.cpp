@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2022 Group of Computer Architecture, University of Bremen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <fstream>
+#include <stdexcept>
+
+#include "trace_ring.h"
+
+using namespace rv32;
+
+TraceRing::TraceRing(size_t size)
+  : records(size)
+{
+	if (size == 0)
+		throw std::invalid_argument("trace ring must not be empty");
+}
+
+void
+TraceRing::dump(const std::string &path)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open())
+		throw std::runtime_error("failed to open " + path);
+
+	uint64_t count = (wrapped) ? records.size() : next;
+	file.write(MAGIC, sizeof(MAGIC));
+	file.write((const char *)&count, sizeof(count));
+
+	// Oldest record is located at the next write position.
+	if (wrapped)
+		file.write((const char *)&records[next], (records.size() - next) * sizeof(Record));
+	file.write((const char *)records.data(), next * sizeof(Record));
+
+	if (!file)
+		throw std::runtime_error("failed to write " + path);
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2022 Group of Computer Architecture, University of Bremen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RISCV_VP_TRACE_RING_H
+#define RISCV_VP_TRACE_RING_H
+
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace rv32 {
+
+// Fixed-size buffer of the most recently executed instructions. In
+// contrast to the --trace-mode, instructions are recorded in binary
+// form and only rendered offline (see vp-trace-decode).
+//
+// A dumped trace consists of the magic string, the number of records
+// (uint64_t), and the records in execution order. All integers are
+// stored in host byte order.
+class TraceRing {
+public:
+	static constexpr char MAGIC[8] = {'V', 'P', 'T', 'R', 'A', 'C', 'E', '1'};
+
+	struct Record {
+		uint32_t pc;
+		uint32_t instr;    // Instruction word, compressed ones are expanded
+		uint32_t rd_value; // Concrete value of rd after execution
+		uint32_t symbolic; // Bit n is set if register xn is symbolic
+	};
+
+private:
+	std::vector<Record> records;
+	size_t next = 0;
+	bool wrapped = false;
+
+public:
+	TraceRing(size_t size);
+
+	// Discard all records, e.g. when starting a new path.
+	void reset(void) {
+		next = 0;
+		wrapped = false;
+	}
+
+	inline void record(uint32_t pc, uint32_t instr, uint32_t rd_value, uint32_t symbolic) {
+		records[next] = Record{pc, instr, rd_value, symbolic};
+		if (++next == records.size()) {
+			next = 0;
+			wrapped = true;
+		}
+	}
+
+	void dump(const std::string &path);
+};
+
+}
+
+#endif
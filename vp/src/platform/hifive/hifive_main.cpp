@@ -39,6 +39,7 @@
 
 #include <cstdlib>
 #include <ctime>
+#include <sstream>
 
 #include "aon.h"
 #include "can.h"
@@ -59,12 +60,16 @@
 #include "symbolic_ctrl.h"
 #include "symbolic_uart.h"
 #include "symbolic_format.h"
+#include "symbolic_stats.h"
 #include "prci.h"
 #include "spi.h"
 #include "uart.h"
 #include "oled.hpp"
 #include "platform/common/options.h"
 #include "coverage.h"
+#include "profiler.h"
+#include "summaries.h"
+#include "trace_ring.h"
 
 #include "gdb-mc/gdb_server.h"
 #include "gdb-mc/gdb_runner.h"
@@ -134,31 +139,50 @@ public:
 	std::string coverage_spec = "";
 	std::string sps_host = "127.0.0.1";
 	std::string sps_service = "2342";
+	std::string sps_cache = "";
+	bool sps_validate = false;
+	std::string profile = "";
+	size_t trace_ring = 0;
+	bool summaries = false;
 
 	HifiveOptions(void) {
         	// clang-format off
 		add_options()
 			("enable-can", po::bool_switch(&enable_can), "enable support for CAN peripheral")
 			("coverage-spec", po::value<std::string>(&coverage_spec), "coverage specification file")
-			("sps-host", po::value<std::string>(&sps_host), "connect to SPS server at given host")
-			("sps-port", po::value<std::string>(&sps_service), "port of SPS server (see --sps-host)");
+			("sps-host", po::value<std::string>(&sps_host), "connect to SPS server at given host (unix:<path> for a unix domain socket)")
+			("sps-port", po::value<std::string>(&sps_service), "port of SPS server (see --sps-host)")
+			("sps-cache", po::value<std::string>(&sps_cache), "persist SPS responses in given file")
+			("sps-validate", po::bool_switch(&sps_validate), "validate cached SPS responses against the server")
+			("profile", po::value<std::string>(&profile), "write folded call stacks of the software to <profile>.<metric>.folded")
+			("trace-ring", po::value<size_t>(&trace_ring), "record the last N executed instructions, dumped next to error test cases")
+			("summaries", po::bool_switch(&summaries), "execute memcpy, memcmp, strlen, and similar functions natively");
         	// clang-format on
 	}
 };
 
 // Global variables to sustain across simulation restarts.
 static Coverage *coverage = nullptr;
+static Profiler *profiler = nullptr;
+static TraceRing *trace_ring = nullptr;
+static Summaries *summaries = nullptr;
 static ProtocolStates *sps = nullptr;
 
+// Coverage restored from a checkpoint, applied once the
+// Coverage instance has been initialized in sc_main.
+static std::optional<std::string> coverage_checkpoint;
+
 // Amount of total packets send to the application.
 size_t pktCnt = 0;
 
 int sc_main(int argc, char **argv) {
+	SymbolicStats::Timer elaboration(SymbolicStats::ELABORATION);
 	HifiveOptions opt;
 	opt.parse(argc, argv);
 
 	if (!sps) {
-		sps = new ProtocolStates(symbolic_context, opt.sps_host, opt.sps_service);
+		sps = new ProtocolStates(symbolic_context, opt.sps_host, opt.sps_service,
+		                         opt.sps_cache, opt.sps_validate);
 	} else {
 		sps->reset();
 	}
@@ -201,10 +225,15 @@ int sc_main(int argc, char **argv) {
 
 	instr_memory_if *instr_mem_if = &iss_mem_if;
 	data_memory_if *data_mem_if = &iss_mem_if;
-	if (opt.use_instr_dmi || opt.use_data_dmi) {
-		std::cerr << "DMI not supported by symbolic execution backend" << std::endl;
-		return 1;
-	}
+
+	// The flash never contains symbolic values, hence always use DMI.
+	MemoryDMI flash_dmi = MemoryDMI::create_start_size_mapping(flash.data, opt.flash_start_addr, flash.size);
+	InstrMemoryProxy instr_mem(flash_dmi, core);
+	iss_mem_if.dmi_ranges.emplace_back(flash_dmi);
+	if (opt.use_instr_dmi)
+		instr_mem_if = &instr_mem;
+	if (opt.use_data_dmi)
+		iss_mem_if.symbolic_dmi_ranges.emplace_back(dram.get_dmi(opt.dram_start_addr));
 
 	bus.ports[0] = new PortMapping(opt.flash_start_addr, opt.flash_end_addr);
 	bus.ports[1] = new PortMapping(opt.dram_start_addr, opt.dram_end_addr);
@@ -275,11 +304,42 @@ int sc_main(int argc, char **argv) {
 		coverage = new Coverage(loader, opt.coverage_spec);
 		coverage->instr_mem = instr_mem_if;
 		coverage->init();
+
+		if (coverage_checkpoint.has_value()) {
+			std::istringstream stream(*coverage_checkpoint);
+			coverage->load(stream);
+			coverage_checkpoint.reset();
+		}
 	}
 	core.coverage = coverage;
 
-	sc_core::sc_start();
-	pktCnt += uart1.pktCnt;
+	if (!profiler && !opt.profile.empty())
+		profiler = new Profiler(loader, opt.profile);
+	if (profiler)
+		profiler->reset();
+	core.profiler = profiler;
+
+	if (!trace_ring && opt.trace_ring > 0)
+		trace_ring = new TraceRing(opt.trace_ring);
+	if (trace_ring)
+		trace_ring->reset();
+	core.trace_ring = trace_ring;
+
+	if (!summaries && opt.summaries)
+		summaries = new Summaries(loader);
+	core.summaries = summaries;
+
+	elaboration.stop();
+
+	// Replayed test cases are executed by processes forked from the
+	// elaborated platform, the forking process does not simulate.
+	if (symbolic_exploration::fork_server()) {
+		SymbolicStats::Timer execution(SymbolicStats::EXECUTION);
+		sc_core::sc_start();
+		execution.stop();
+		symbolic_stats.increment(SymbolicStats::INSTRUCTIONS, core.total_num_instr);
+		pktCnt += uart1.pktCnt;
+	}
 
 	for (auto mapping : bus.ports)
 		delete mapping;
@@ -294,6 +354,29 @@ size_t executed_branches(void) {
 	return coverage->executed_branches();
 }
 
+size_t path_novelty(void) {
+	return coverage->path_novelty();
+}
+
+std::string checkpoint_coverage(void) {
+	std::ostringstream stream;
+	if (coverage)
+		coverage->save(stream);
+	return stream.str();
+}
+
+void restore_coverage(const std::string &data) {
+	coverage_checkpoint = data;
+}
+
+void merge_coverage(const std::string &data) {
+	if (!coverage)
+		return;
+
+	std::istringstream stream(data);
+	coverage->merge(stream);
+}
+
 double dump_instr_coverage(void) {
 	return coverage->dump_instr_coverage();
 }
@@ -309,6 +392,19 @@ void dump_coverage(void) {
 	}
 }
 
+void dump_profile(void) {
+	if (profiler)
+		profiler->dump();
+}
+
+bool dump_trace(const std::string &path) {
+	if (!trace_ring)
+		return false;
+
+	trace_ring->dump(path);
+	return true;
+}
+
 int main(int argc, char **argv) {
 	return symbolic_explore(argc, argv);
 }
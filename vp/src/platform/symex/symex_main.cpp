@@ -39,6 +39,7 @@
 
 #include <cstdlib>
 #include <ctime>
+#include <sstream>
 
 #include "core/common/clint.h"
 #include "elf_loader.h"
@@ -50,10 +51,14 @@
 #include "symbolic_context.h"
 #include "symbolic_explore.h"
 #include "symbolic_ctrl.h"
+#include "symbolic_stats.h"
 #include "symex_sensor.h"
 #include "syscall.h"
 #include "platform/common/options.h"
 #include "coverage.h"
+#include "profiler.h"
+#include "summaries.h"
+#include "trace_ring.h"
 
 #include "gdb-mc/gdb_server.h"
 #include "gdb-mc/gdb_runner.h"
@@ -85,19 +90,33 @@ public:
 	addr_t sensor_end_addr = 0x02020132;
 
 	bool quiet = false;
+	std::string profile = "";
+	size_t trace_ring = 0;
+	bool summaries = false;
 
 	SymexOptions(void) {
 		// clang-format off
 		add_options()
-			("quiet", po::bool_switch(&quiet), "do not output register values on exit");
+			("quiet", po::bool_switch(&quiet), "do not output register values on exit")
+			("profile", po::value<std::string>(&profile), "write folded call stacks of the software to <profile>.<metric>.folded")
+			("trace-ring", po::value<size_t>(&trace_ring), "record the last N executed instructions, dumped next to error test cases")
+			("summaries", po::bool_switch(&summaries), "execute memcpy, memcmp, strlen, and similar functions natively");
         	// clang-format on
         }
 };
 
-// Global variable to sustain across simulation restarts.
+// Global variables to sustain across simulation restarts.
 static Coverage *coverage = nullptr;
+static Profiler *profiler = nullptr;
+static TraceRing *trace_ring = nullptr;
+static Summaries *summaries = nullptr;
+
+// Coverage restored from a checkpoint, applied once the
+// Coverage instance has been initialized in sc_main.
+static std::optional<std::string> coverage_checkpoint;
 
 int sc_main(int argc, char **argv) {
+	SymbolicStats::Timer elaboration(SymbolicStats::ELABORATION);
 	SymexOptions opt;
 	opt.parse(argc, argv);
 
@@ -120,10 +139,11 @@ int sc_main(int argc, char **argv) {
 
 	instr_memory_if *instr_mem_if = &core_mem_if;
 	data_memory_if *data_mem_if = &core_mem_if;
-	if (opt.use_instr_dmi || opt.use_data_dmi) {
-		std::cerr << "DMI not supported by symbolic execution backend" << std::endl;
-		return 1;
-	}
+
+	// Instructions and data are both located in the symbolic memory,
+	// instruction fetches only use the concrete part of the DMI range.
+	if (opt.use_instr_dmi || opt.use_data_dmi)
+		core_mem_if.symbolic_dmi_ranges.emplace_back(mem.get_dmi(opt.mem_start_addr));
 
 	loader.load_executable_image(mem, opt.mem_size, opt.mem_start_addr, false);
 	core.init(instr_mem_if, data_mem_if, &clint, loader.get_entrypoint(), rv32_align_address(opt.mem_end_addr));
@@ -176,12 +196,43 @@ int sc_main(int argc, char **argv) {
 		coverage = new Coverage(loader);
 		coverage->instr_mem = instr_mem_if;
 		coverage->init();
+
+		if (coverage_checkpoint.has_value()) {
+			std::istringstream stream(*coverage_checkpoint);
+			coverage->load(stream);
+			coverage_checkpoint.reset();
+		}
 	}
 	core.coverage = coverage;
 
-	sc_core::sc_start();
-	if (!opt.quiet)
-		core.show();
+	if (!profiler && !opt.profile.empty())
+		profiler = new Profiler(loader, opt.profile);
+	if (profiler)
+		profiler->reset();
+	core.profiler = profiler;
+
+	if (!trace_ring && opt.trace_ring > 0)
+		trace_ring = new TraceRing(opt.trace_ring);
+	if (trace_ring)
+		trace_ring->reset();
+	core.trace_ring = trace_ring;
+
+	if (!summaries && opt.summaries)
+		summaries = new Summaries(loader);
+	core.summaries = summaries;
+
+	elaboration.stop();
+
+	// Replayed test cases are executed by processes forked from the
+	// elaborated platform, the forking process does not simulate.
+	if (symbolic_exploration::fork_server()) {
+		SymbolicStats::Timer execution(SymbolicStats::EXECUTION);
+		sc_core::sc_start();
+		execution.stop();
+		symbolic_stats.increment(SymbolicStats::INSTRUCTIONS, core.total_num_instr);
+		if (!opt.quiet)
+			core.show();
+	}
 
 	for (auto mapping : bus.ports)
 		delete mapping;
@@ -197,6 +248,29 @@ size_t executed_branches(void) {
 	return coverage->executed_branches();
 }
 
+size_t path_novelty(void) {
+	return coverage->path_novelty();
+}
+
+std::string checkpoint_coverage(void) {
+	std::ostringstream stream;
+	if (coverage)
+		coverage->save(stream);
+	return stream.str();
+}
+
+void restore_coverage(const std::string &data) {
+	coverage_checkpoint = data;
+}
+
+void merge_coverage(const std::string &data) {
+	if (!coverage)
+		return;
+
+	std::istringstream stream(data);
+	coverage->merge(stream);
+}
+
 double dump_instr_coverage(void) {
 	return coverage->dump_instr_coverage();
 }
@@ -208,6 +282,19 @@ void dump_coverage(void) {
 	}
 }
 
+void dump_profile(void) {
+	if (profiler)
+		profiler->dump();
+}
+
+bool dump_trace(const std::string &path) {
+	if (!trace_ring)
+		return false;
+
+	trace_ring->dump(path);
+	return true;
+}
+
 int main(int argc, char **argv) {
 	return symbolic_explore(argc, argv);
 }
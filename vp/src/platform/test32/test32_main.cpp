@@ -102,7 +102,7 @@ public:
 	}
 };
 
-void dump_test_signature(TestOptions &opt, clover::ConcolicMemory &mem, ELFLoader &loader) {
+void dump_test_signature(TestOptions &opt, SymbolicMemory &mem, ELFLoader &loader) {
     auto begin_sig = loader.get_begin_signature_address();
     auto end_sig = loader.get_end_signature_address();
 
@@ -121,13 +121,12 @@ void dump_test_signature(TestOptions &opt, clover::ConcolicMemory &mem, ELFLoade
     auto end = end_sig - opt.mem_start_addr;
 
     std::ofstream sigfile(opt.test_signature, std::ios::out);
-    clover::Solver &solver = symbolic_context.solver;
 
     auto n = begin;
     assert (n % 4 == 0);
     while (n < end) {
-        auto word = mem.load(n, 4);
-        auto p = solver.getValue<uint32_t>(word->concrete);
+        uint32_t p;
+        memcpy(&p, &mem.data[n], sizeof(p));
         sigfile << std::hex << std::setw(8) << std::setfill('0') << p << std::endl;
         n += 4;
     }
@@ -137,14 +136,38 @@ size_t executed_branches(void) {
 	return 0;
 }
 
+size_t path_novelty(void) {
+	return 0;
+}
+
 void dump_instr_coverage(void) {
 	return;
 }
 
+std::string checkpoint_coverage(void) {
+	return "";
+}
+
+void restore_coverage(const std::string &) {
+	return;
+}
+
+void merge_coverage(const std::string &) {
+	return;
+}
+
 void dump_coverage(void) {
 	return;
 }
 
+void dump_profile(void) {
+	return;
+}
+
+bool dump_trace(const std::string &) {
+	return false;
+}
+
 int sc_main(int argc, char **argv) {
 	TestOptions opt;
 	opt.parse(argc, argv);
@@ -168,10 +191,8 @@ int sc_main(int argc, char **argv) {
 
     instr_memory_if *instr_mem_if = &core_mem_if;
     data_memory_if *data_mem_if = &core_mem_if;
-    if (opt.use_instr_dmi || opt.use_data_dmi) {
-            std::cerr << "DMI not supported by symbolic execution backend" << std::endl;
-            return 1;
-    }
+    if (opt.use_instr_dmi || opt.use_data_dmi)
+        core_mem_if.symbolic_dmi_ranges.emplace_back(mem.get_dmi(opt.mem_start_addr));
 
     loader.load_executable_image(mem, opt.mem_size, opt.mem_start_addr);
     core.init(instr_mem_if, data_mem_if, &clint, loader.get_entrypoint(), rv32_align_address(opt.mem_end_addr));
@@ -237,7 +258,7 @@ int sc_main(int argc, char **argv) {
     core.show();
 
     if (!opt.test_signature.empty()) {
-        dump_test_signature(opt, mem.memory, loader);
+        dump_test_signature(opt, mem, loader);
     }
 
     return 0;
@@ -0,0 +1,271 @@
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <clover/clover.h>
+
+using namespace clover;
+
+/* Microbenchmarks for the primitives invoked by the instruction set
+ * simulator on every executed instruction. Each benchmark is run until
+ * it has taken at least the minimum runtime, results are written to
+ * stdout as one JSON object per line. */
+
+typedef std::chrono::steady_clock Clock;
+
+static std::chrono::nanoseconds minTime = std::chrono::milliseconds(500);
+static const char *filter = nullptr;
+
+/* Prevents the compiler from discarding benchmarked computations */
+static volatile const void *sink;
+
+static void
+report(const std::string &name, uint64_t iterations, uint64_t ops, Clock::duration elapsed, const std::string &extra = "")
+{
+	double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+
+	std::cout << "{\"name\":\"" << name << "\","
+	          << "\"iterations\":" << iterations << ","
+	          << "\"ops\":" << ops << ","
+	          << "\"ns_per_op\":" << ns / ops
+	          << extra << "}" << std::endl;
+}
+
+static bool
+selected(const std::string &name)
+{
+	return !filter || name.find(filter) != std::string::npos;
+}
+
+/* Run fn, which performs opsPerIter operations, with an increasing
+ * number of iterations until the minimum runtime is reached. */
+template <typename F>
+static void
+bench(const std::string &name, uint64_t opsPerIter, F fn)
+{
+	if (!selected(name))
+		return;
+
+	for (uint64_t iterations = 1;; iterations *= 2) {
+		auto start = Clock::now();
+		for (uint64_t i = 0; i < iterations; i++)
+			fn();
+		auto elapsed = Clock::now() - start;
+
+		if (elapsed >= minTime) {
+			report(name, iterations, iterations * opsPerIter, elapsed);
+			return;
+		}
+	}
+}
+
+typedef std::shared_ptr<ConcolicValue> (ConcolicValue::*BinaryOp)(std::shared_ptr<ConcolicValue>);
+
+static void
+benchConcolic(Solver &solver)
+{
+	static const std::vector<std::pair<const char *, BinaryOp>> ops = {
+		{"add", &ConcolicValue::add},
+		{"sub", &ConcolicValue::sub},
+		{"band", &ConcolicValue::band},
+		{"lshl", &ConcolicValue::lshl},
+		{"mul", &ConcolicValue::mul},
+		{"eq", &ConcolicValue::eq},
+		{"ult", &ConcolicValue::ult},
+	};
+
+	auto concrete = solver.BVC(std::nullopt, (uint32_t)0xdeadbeef);
+	auto symbolic = solver.BVC(std::string("bench_word"), (uint32_t)0xdeadbeef);
+	auto shamt = solver.BVC(std::nullopt, (uint32_t)3);
+
+	for (auto &op : ops) {
+		auto fn = op.second;
+		auto rhs = (fn == &ConcolicValue::lshl) ? shamt : concrete;
+
+		bench(std::string("concolic.") + op.first + ".concrete", 1, [&]() {
+			sink = ((*concrete).*fn)(rhs).get();
+		});
+		bench(std::string("concolic.") + op.first + ".symbolic", 1, [&]() {
+			sink = ((*symbolic).*fn)(rhs).get();
+		});
+	}
+}
+
+static void
+benchSolver(Solver &solver)
+{
+	uint32_t value = 0;
+	bench("solver.bvc", 1, [&]() {
+		sink = solver.BVC(std::nullopt, value++).get();
+	});
+
+	uint8_t input[4] = {0xde, 0xad, 0xbe, 0xef};
+	bench("solver.bvc_bytes", 1, [&]() {
+		sink = solver.BVC(input, sizeof(input)).get();
+	});
+
+	auto concrete = solver.BVC(std::nullopt, (uint32_t)0xdeadbeef);
+	auto symbolic = solver.BVC(std::string("bench_word"), (uint32_t)0xdeadbeef);
+
+	uint8_t output[4];
+	bench("solver.bvc_to_bytes.concrete", 1, [&]() {
+		solver.BVCToBytes(concrete, output, sizeof(output));
+		sink = output;
+	});
+	bench("solver.bvc_to_bytes.symbolic", 1, [&]() {
+		solver.BVCToBytes(symbolic, output, sizeof(output));
+		sink = output;
+	});
+}
+
+static void
+benchMemory(Solver &solver)
+{
+	ConcolicMemory memory(solver);
+
+	auto concrete = solver.BVC(std::nullopt, (uint32_t)0xdeadbeef);
+	auto symbolic = solver.BVC(std::string("bench_word"), (uint32_t)0xdeadbeef);
+
+	for (unsigned size : {1, 2, 4}) {
+		auto suffix = std::to_string(size);
+
+		bench("memory.store" + suffix + ".concrete", 1, [&]() {
+			memory.store(0x1000, concrete, size);
+		});
+		bench("memory.store" + suffix + ".symbolic", 1, [&]() {
+			memory.store(0x1000, symbolic, size);
+		});
+
+		memory.store(0x1000, concrete, size);
+		bench("memory.load" + suffix + ".concrete", 1, [&]() {
+			sink = memory.load(0x1000, size).get();
+		});
+		memory.store(0x1000, symbolic, size);
+		bench("memory.load" + suffix + ".symbolic", 1, [&]() {
+			sink = memory.load(0x1000, size).get();
+		});
+	}
+}
+
+/* Branch conditions of a path with the given depth, each condition
+ * constrains a separate symbolic byte and evaluates to false. */
+static std::vector<std::shared_ptr<BitVector>>
+makePath(Solver &solver, size_t depth)
+{
+	std::vector<std::shared_ptr<BitVector>> conds;
+	auto magic = solver.BVC(std::nullopt, (uint8_t)'A');
+
+	for (size_t i = 0; i < depth; i++) {
+		auto byte = solver.BVC("bench_byte" + std::to_string(i), (uint8_t)0);
+		conds.push_back(*byte->eq(magic)->symbolic);
+	}
+
+	return conds;
+}
+
+static void
+benchTrace(Solver &solver)
+{
+	for (size_t depth : {16, 256, 1024}) {
+		auto conds = makePath(solver, depth);
+
+		/* Re-executing the same path, as done by the explorer for
+		 * each new input, only extends the execution tree once. */
+		Trace trace(solver);
+		bench("trace.add.depth" + std::to_string(depth), depth, [&]() {
+			trace.reset();
+			for (size_t i = 0; i < conds.size(); i++)
+				trace.add(false, conds[i], i * 4, 0);
+		});
+	}
+
+	/* Query construction is private to the Trace, it is measured
+	 * through findNewPath and the QueryBuildTime statistic. Since
+	 * queries repeat across iterations, the solver time is mostly
+	 * spent in the caching layers of the solver chain. */
+	for (size_t depth : {16, 64, 256}) {
+		auto name = "trace.new_query.depth" + std::to_string(depth);
+		if (!selected(name))
+			continue;
+
+		auto conds = makePath(solver, depth);
+		auto buildStart = stats::queryBuildTime.getValue();
+
+		uint64_t iterations = 0, queries = 0;
+		Clock::duration elapsed(0);
+		do {
+			Trace trace(solver);
+			for (size_t i = 0; i < conds.size(); i++)
+				trace.add(false, conds[i], i * 4, 0);
+
+			auto start = Clock::now();
+			while (trace.findNewPath(0).has_value())
+				queries++;
+			elapsed += Clock::now() - start;
+			iterations++;
+		} while (elapsed < minTime);
+
+		/* KLEE timer statistics are recorded in microseconds */
+		double build = (stats::queryBuildTime.getValue() - buildStart) * 1e3;
+
+		std::ostringstream extra;
+		extra << ",\"query_build_ns_per_op\":" << build / queries;
+		report(name, iterations, queries, elapsed, extra.str());
+	}
+}
+
+static void
+benchContext(Solver &solver)
+{
+	ExecutionContext ctx(solver);
+
+	for (size_t size : {1, 4, 16}) {
+		bench("context.get_symbolic_bytes" + std::to_string(size), 1, [&]() {
+			sink = ctx.getSymbolicBytes("bench_input" + std::to_string(size), size).get();
+		});
+		ctx.clear();
+	}
+}
+
+static void
+usage(const char *progname)
+{
+	std::cerr << "USAGE: " << progname << " [-t MILLISECONDS] [FILTER]" << std::endl;
+	exit(EXIT_FAILURE);
+}
+
+int
+main(int argc, char **argv)
+{
+	int opt;
+	while ((opt = getopt(argc, argv, "t:")) != -1) {
+		switch (opt) {
+		case 't':
+			minTime = std::chrono::milliseconds(strtoul(optarg, nullptr, 10));
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	if (argc - optind > 1)
+		usage(argv[0]);
+	else if (argc - optind == 1)
+		filter = argv[optind];
+
+	Solver solver;
+
+	benchConcolic(solver);
+	benchSolver(solver);
+	benchMemory(solver);
+	benchTrace(solver);
+	benchContext(solver);
+
+	return EXIT_SUCCESS;
+}
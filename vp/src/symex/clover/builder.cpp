@@ -0,0 +1,310 @@
+#include <algorithm>
+
+#include <clover/clover.h>
+
+#include "builder.h"
+
+using namespace clover;
+
+klee::Statistic stats::exprsShared("ExprsShared", "Eshared");
+klee::Statistic stats::exprsUnique("ExprsUnique", "Eunique");
+
+/* Minimum table size before unreferenced nodes are released */
+#define HASHCONS_MIN_THRESHOLD 4096
+
+ChainedBuilder::ChainedBuilder(klee::ExprBuilder *_base)
+    : base(_base)
+{
+	return;
+}
+
+ChainedBuilder::~ChainedBuilder(void)
+{
+	delete base;
+}
+
+klee::ref<klee::Expr>
+ChainedBuilder::Constant(const llvm::APInt &value)
+{
+	return finish(base->Constant(value));
+}
+
+klee::ref<klee::Expr>
+ChainedBuilder::NotOptimized(const klee::ref<klee::Expr> &e)
+{
+	return finish(base->NotOptimized(e));
+}
+
+klee::ref<klee::Expr>
+ChainedBuilder::Read(const klee::UpdateList &updates, const klee::ref<klee::Expr> &index)
+{
+	return finish(base->Read(updates, index));
+}
+
+klee::ref<klee::Expr>
+ChainedBuilder::Select(const klee::ref<klee::Expr> &cond, const klee::ref<klee::Expr> &lhs, const klee::ref<klee::Expr> &rhs)
+{
+	return finish(base->Select(cond, lhs, rhs));
+}
+
+klee::ref<klee::Expr>
+ChainedBuilder::Concat(const klee::ref<klee::Expr> &lhs, const klee::ref<klee::Expr> &rhs)
+{
+	return finish(base->Concat(lhs, rhs));
+}
+
+klee::ref<klee::Expr>
+ChainedBuilder::Extract(const klee::ref<klee::Expr> &e, unsigned offset, klee::Expr::Width width)
+{
+	return finish(base->Extract(e, offset, width));
+}
+
+klee::ref<klee::Expr>
+ChainedBuilder::ZExt(const klee::ref<klee::Expr> &e, klee::Expr::Width width)
+{
+	return finish(base->ZExt(e, width));
+}
+
+klee::ref<klee::Expr>
+ChainedBuilder::SExt(const klee::ref<klee::Expr> &e, klee::Expr::Width width)
+{
+	return finish(base->SExt(e, width));
+}
+
+klee::ref<klee::Expr>
+ChainedBuilder::Not(const klee::ref<klee::Expr> &e)
+{
+	return finish(base->Not(e));
+}
+
+#define CLOVER_BINARY_BUILDER(NAME)                                                                \
+	klee::ref<klee::Expr>                                                                      \
+	ChainedBuilder::NAME(const klee::ref<klee::Expr> &lhs, const klee::ref<klee::Expr> &rhs) \
+	{                                                                                          \
+		return finish(base->NAME(lhs, rhs));                                               \
+	}
+
+CLOVER_BINARY_BUILDER(Add)
+CLOVER_BINARY_BUILDER(Sub)
+CLOVER_BINARY_BUILDER(Mul)
+CLOVER_BINARY_BUILDER(UDiv)
+CLOVER_BINARY_BUILDER(SDiv)
+CLOVER_BINARY_BUILDER(URem)
+CLOVER_BINARY_BUILDER(SRem)
+CLOVER_BINARY_BUILDER(And)
+CLOVER_BINARY_BUILDER(Or)
+CLOVER_BINARY_BUILDER(Xor)
+CLOVER_BINARY_BUILDER(Shl)
+CLOVER_BINARY_BUILDER(LShr)
+CLOVER_BINARY_BUILDER(AShr)
+CLOVER_BINARY_BUILDER(Eq)
+CLOVER_BINARY_BUILDER(Ne)
+CLOVER_BINARY_BUILDER(Ult)
+CLOVER_BINARY_BUILDER(Ule)
+CLOVER_BINARY_BUILDER(Ugt)
+CLOVER_BINARY_BUILDER(Uge)
+CLOVER_BINARY_BUILDER(Slt)
+CLOVER_BINARY_BUILDER(Sle)
+CLOVER_BINARY_BUILDER(Sgt)
+CLOVER_BINARY_BUILDER(Sge)
+
+#undef CLOVER_BINARY_BUILDER
+
+/* Constants are not interned, equal constants are distinct nodes */
+static bool
+sameOperand(const klee::ref<klee::Expr> &a, const klee::ref<klee::Expr> &b)
+{
+	if (a.get() == b.get())
+		return true;
+
+	auto ca = klee::dyn_cast<klee::ConstantExpr>(a);
+	auto cb = klee::dyn_cast<klee::ConstantExpr>(b);
+	return ca && cb && ca->getWidth() == cb->getWidth() && ca->getAPValue() == cb->getAPValue();
+}
+
+bool
+HashConsingBuilder::NodeEq::operator()(const klee::ref<klee::Expr> &a, const klee::ref<klee::Expr> &b) const
+{
+	if (a.get() == b.get())
+		return true;
+	if (a->getKind() != b->getKind() || a->getWidth() != b->getWidth() || a->hash() != b->hash())
+		return false;
+
+	unsigned kids = a->getNumKids();
+	if (kids != b->getNumKids())
+		return false;
+	for (unsigned i = 0; i < kids; i++) {
+		if (!sameOperand(a->getKid(i), b->getKid(i)))
+			return a->compare(*b) == 0;
+	}
+
+	// Operands are identical, only compare node attributes.
+	if (auto ea = klee::dyn_cast<klee::ExtractExpr>(a))
+		return ea->offset == klee::cast<klee::ExtractExpr>(b)->offset;
+	if (auto ra = klee::dyn_cast<klee::ReadExpr>(a))
+		return ra->updates.compare(klee::cast<klee::ReadExpr>(b)->updates) == 0;
+	return true;
+}
+
+HashConsingBuilder::HashConsingBuilder(klee::ExprBuilder *_base)
+    : ChainedBuilder(_base), threshold(HASHCONS_MIN_THRESHOLD)
+{
+	return;
+}
+
+void
+HashConsingBuilder::collect(void)
+{
+	// Releasing a node may leave its operands unreferenced, these
+	// are released by one of the subsequent collections.
+	for (auto it = nodes.begin(); it != nodes.end();) {
+		if (it->get()->_refCount.getCount() == 1)
+			it = nodes.erase(it);
+		else
+			it++;
+	}
+
+	threshold = std::max((size_t)HASHCONS_MIN_THRESHOLD, nodes.size() * 2);
+}
+
+klee::ref<klee::Expr>
+HashConsingBuilder::finish(const klee::ref<klee::Expr> &e)
+{
+	if (klee::isa<klee::ConstantExpr>(e))
+		return e;
+
+	auto r = nodes.insert(e);
+	if (!r.second) {
+		++stats::exprsShared;
+		return *r.first;
+	}
+
+	++stats::exprsUnique;
+	if (nodes.size() >= threshold)
+		collect();
+
+	return e;
+}
+
+ExtractFoldingBuilder::ExtractFoldingBuilder(klee::ExprBuilder *_base)
+    : ChainedBuilder(_base)
+{
+	return;
+}
+
+/* Returns the concatenation of lhs and rhs as a single extract,
+ * a null reference is returned if they are not contiguous. */
+klee::ref<klee::Expr>
+ExtractFoldingBuilder::merge(const klee::ref<klee::Expr> &lhs, const klee::ref<klee::Expr> &rhs)
+{
+	auto l = klee::dyn_cast<klee::ExtractExpr>(lhs);
+	if (!l)
+		return nullptr;
+
+	auto r = klee::dyn_cast<klee::ExtractExpr>(rhs);
+	if (r && l->expr.get() == r->expr.get() && l->offset == r->offset + r->width)
+		return Extract(l->expr, r->offset, l->width + r->width);
+
+	// Upper bits of an extension, e.g. Concat(Extract(SExt(x), w, n), x),
+	// the lower bits may be extended by the same kind of extension.
+	auto kind = l->expr->getKind();
+	if ((kind == klee::Expr::ZExt || kind == klee::Expr::SExt) && l->offset == rhs->getWidth()) {
+		auto src = l->expr->getKid(0);
+		if (src.get() == rhs.get() || (rhs->getKind() == kind && rhs->getKid(0).get() == src.get()))
+			return Extract(l->expr, 0, l->width + rhs->getWidth());
+	}
+
+	return nullptr;
+}
+
+klee::ref<klee::Expr>
+ExtractFoldingBuilder::Concat(const klee::ref<klee::Expr> &lhs, const klee::ref<klee::Expr> &rhs)
+{
+	auto ce = klee::dyn_cast<klee::ConstantExpr>(lhs);
+	auto rce = klee::dyn_cast<klee::ConstantExpr>(rhs);
+	if (ce && rce)
+		return ce->Concat(rce);
+	else if (ce && ce->isZero())
+		return ZExt(rhs, lhs->getWidth() + rhs->getWidth());
+
+	auto e = merge(lhs, rhs);
+	if (e)
+		return e;
+
+	// Memory loads create right-nested concatenations, stores of
+	// partially symbolic values may also create left-nested ones.
+	if (auto rc = klee::dyn_cast<klee::ConcatExpr>(rhs)) {
+		e = merge(lhs, rc->getLeft());
+		if (e)
+			return Concat(e, rc->getRight());
+	}
+	if (auto lc = klee::dyn_cast<klee::ConcatExpr>(lhs)) {
+		e = merge(lc->getRight(), rhs);
+		if (e)
+			return Concat(lc->getLeft(), e);
+	}
+
+	return ChainedBuilder::Concat(lhs, rhs);
+}
+
+klee::ref<klee::Expr>
+ExtractFoldingBuilder::Extract(const klee::ref<klee::Expr> &e, unsigned offset, klee::Expr::Width width)
+{
+	if (offset == 0 && width == e->getWidth())
+		return e;
+	else if (auto ce = klee::dyn_cast<klee::ConstantExpr>(e))
+		return ce->Extract(offset, width);
+
+	if (auto ee = klee::dyn_cast<klee::ExtractExpr>(e))
+		return Extract(ee->expr, ee->offset + offset, width);
+
+	if (auto ce = klee::dyn_cast<klee::ConcatExpr>(e)) {
+		auto rwidth = ce->getRight()->getWidth();
+		if (offset + width <= rwidth)
+			return Extract(ce->getRight(), offset, width);
+		else if (offset >= rwidth)
+			return Extract(ce->getLeft(), offset - rwidth, width);
+	}
+
+	auto kind = e->getKind();
+	if (kind == klee::Expr::ZExt || kind == klee::Expr::SExt) {
+		auto src = e->getKid(0);
+		auto swidth = src->getWidth();
+
+		if (offset + width <= swidth)
+			return Extract(src, offset, width);
+		else if (offset < swidth)
+			return (kind == klee::Expr::ZExt) ? ZExt(Extract(src, offset, swidth - offset), width)
+			                                  : SExt(Extract(src, offset, swidth - offset), width);
+		else if (kind == klee::Expr::ZExt)
+			return Constant(0, width);
+	}
+
+	return ChainedBuilder::Extract(e, offset, width);
+}
+
+klee::ref<klee::Expr>
+ExtractFoldingBuilder::ZExt(const klee::ref<klee::Expr> &e, klee::Expr::Width width)
+{
+	if (width <= e->getWidth())
+		return Extract(e, 0, width);
+	else if (auto ce = klee::dyn_cast<klee::ConstantExpr>(e))
+		return ce->ZExt(width);
+	else if (e->getKind() == klee::Expr::ZExt)
+		return ZExt(e->getKid(0), width);
+
+	return ChainedBuilder::ZExt(e, width);
+}
+
+klee::ref<klee::Expr>
+ExtractFoldingBuilder::SExt(const klee::ref<klee::Expr> &e, klee::Expr::Width width)
+{
+	if (width <= e->getWidth())
+		return Extract(e, 0, width);
+	else if (auto ce = klee::dyn_cast<klee::ConstantExpr>(e))
+		return ce->SExt(width);
+	else if (e->getKind() == klee::Expr::SExt)
+		return SExt(e->getKid(0), width);
+
+	return ChainedBuilder::SExt(e, width);
+}
@@ -0,0 +1,121 @@
+#ifndef CLOVER_BUILDER_H
+#define CLOVER_BUILDER_H
+
+#include <klee/Expr/Expr.h>
+#include <klee/Expr/ExprBuilder.h>
+#include <klee/Expr/ExprHashMap.h>
+
+#include <unordered_set>
+
+namespace clover {
+
+/* ExprBuilder which forwards the construction of all expressions to a
+ * base builder, owned by this builder. Each expression returned by the
+ * base builder is passed through finish(). Layers of the builder chain
+ * (see Solver::Solver) override finish() or individual expressions. */
+class ChainedBuilder : public klee::ExprBuilder {
+protected:
+	klee::ExprBuilder *base;
+
+	virtual klee::ref<klee::Expr> finish(const klee::ref<klee::Expr> &e)
+	{
+		return e;
+	}
+
+public:
+	ChainedBuilder(klee::ExprBuilder *_base);
+	~ChainedBuilder(void);
+
+	using klee::ExprBuilder::Constant;
+
+	klee::ref<klee::Expr> Constant(const llvm::APInt &value) override;
+	klee::ref<klee::Expr> NotOptimized(const klee::ref<klee::Expr> &e) override;
+	klee::ref<klee::Expr> Read(const klee::UpdateList &updates, const klee::ref<klee::Expr> &index) override;
+	klee::ref<klee::Expr> Select(const klee::ref<klee::Expr> &cond, const klee::ref<klee::Expr> &lhs, const klee::ref<klee::Expr> &rhs) override;
+	klee::ref<klee::Expr> Concat(const klee::ref<klee::Expr> &lhs, const klee::ref<klee::Expr> &rhs) override;
+	klee::ref<klee::Expr> Extract(const klee::ref<klee::Expr> &e, unsigned offset, klee::Expr::Width width) override;
+	klee::ref<klee::Expr> ZExt(const klee::ref<klee::Expr> &e, klee::Expr::Width width) override;
+	klee::ref<klee::Expr> SExt(const klee::ref<klee::Expr> &e, klee::Expr::Width width) override;
+	klee::ref<klee::Expr> Not(const klee::ref<klee::Expr> &e) override;
+
+#define CLOVER_BINARY_BUILDER(NAME) \
+	klee::ref<klee::Expr> NAME(const klee::ref<klee::Expr> &lhs, const klee::ref<klee::Expr> &rhs) override;
+
+	CLOVER_BINARY_BUILDER(Add)
+	CLOVER_BINARY_BUILDER(Sub)
+	CLOVER_BINARY_BUILDER(Mul)
+	CLOVER_BINARY_BUILDER(UDiv)
+	CLOVER_BINARY_BUILDER(SDiv)
+	CLOVER_BINARY_BUILDER(URem)
+	CLOVER_BINARY_BUILDER(SRem)
+	CLOVER_BINARY_BUILDER(And)
+	CLOVER_BINARY_BUILDER(Or)
+	CLOVER_BINARY_BUILDER(Xor)
+	CLOVER_BINARY_BUILDER(Shl)
+	CLOVER_BINARY_BUILDER(LShr)
+	CLOVER_BINARY_BUILDER(AShr)
+	CLOVER_BINARY_BUILDER(Eq)
+	CLOVER_BINARY_BUILDER(Ne)
+	CLOVER_BINARY_BUILDER(Ult)
+	CLOVER_BINARY_BUILDER(Ule)
+	CLOVER_BINARY_BUILDER(Ugt)
+	CLOVER_BINARY_BUILDER(Uge)
+	CLOVER_BINARY_BUILDER(Slt)
+	CLOVER_BINARY_BUILDER(Sle)
+	CLOVER_BINARY_BUILDER(Sgt)
+	CLOVER_BINARY_BUILDER(Sge)
+
+#undef CLOVER_BINARY_BUILDER
+};
+
+/* Hash-consing layer: Structurally equal expressions are represented by
+ * a single node. Must be placed directly on top of the default builder
+ * to intern all nodes constructed by the chain. Constants are not
+ * interned. Nodes which are only referenced by the table are released
+ * periodically, the table thus behaves like a set of weak references. */
+class HashConsingBuilder : public ChainedBuilder {
+private:
+	/* Operands of new nodes are usually interned already, in which
+	 * case nodes are compared without recursing into operands. */
+	struct NodeEq {
+		bool operator()(const klee::ref<klee::Expr> &a, const klee::ref<klee::Expr> &b) const;
+	};
+
+	std::unordered_set<klee::ref<klee::Expr>, klee::util::ExprHash, NodeEq> nodes;
+
+	/* Table size triggering the next release of unreferenced nodes */
+	size_t threshold;
+
+	void collect(void);
+
+protected:
+	klee::ref<klee::Expr> finish(const klee::ref<klee::Expr> &e) override;
+
+public:
+	HashConsingBuilder(klee::ExprBuilder *_base);
+};
+
+/* Folds the per-byte extracts and concatenations created by memory
+ * accesses (see ConcolicMemory). Concatenations of contiguous extracts
+ * from the same expression are merged, extracts from concatenations and
+ * extensions are applied to the concatenated or extended expressions.
+ * Must be placed on top of the hash-consing layer, equal expressions
+ * are detected by comparing pointers. Rewrites are applied recursively
+ * by this layer, bypassing the constant folding layer above it, constant
+ * operands are thus folded by this layer as well. */
+class ExtractFoldingBuilder : public ChainedBuilder {
+private:
+	klee::ref<klee::Expr> merge(const klee::ref<klee::Expr> &lhs, const klee::ref<klee::Expr> &rhs);
+
+public:
+	ExtractFoldingBuilder(klee::ExprBuilder *_base);
+
+	klee::ref<klee::Expr> Concat(const klee::ref<klee::Expr> &lhs, const klee::ref<klee::Expr> &rhs) override;
+	klee::ref<klee::Expr> Extract(const klee::ref<klee::Expr> &e, unsigned offset, klee::Expr::Width width) override;
+	klee::ref<klee::Expr> ZExt(const klee::ref<klee::Expr> &e, klee::Expr::Width width) override;
+	klee::ref<klee::Expr> SExt(const klee::ref<klee::Expr> &e, klee::Expr::Width width) override;
+};
+
+} // namespace clover
+
+#endif
@@ -0,0 +1,147 @@
+#include <iostream>
+#include <random>
+
+#include <stdlib.h>
+
+#include <clover/clover.h>
+#include <klee/Expr/Constraints.h>
+#include <klee/Expr/ExprUtil.h>
+
+#include "../builder.h"
+
+using namespace clover;
+
+/* Randomized check of the rewrites performed by the builder chain (see
+ * Solver::Solver). Random trees of extracts, concatenations, and
+ * extensions are constructed using the chain and using KLEE's default
+ * builders. Both expressions must be equivalent, and expressions which
+ * do not read any array must be folded to a constant. */
+
+typedef klee::ref<klee::Expr> Expr;
+
+/* Number of random expressions checked by default */
+#define DEFAULT_ITERATIONS 500
+
+/* Maximum depth of the random expression trees */
+#define MAX_DEPTH 6
+
+static klee::ArrayCache arrays;
+static const klee::Array *vars[2];
+
+/* Constructs a 32-bit value from single byte reads, as done by
+ * Solver::BVC(SymbolID, IntValue). */
+static Expr
+readWord(klee::ExprBuilder *builder, const klee::Array *array)
+{
+	klee::UpdateList ul(array, 0);
+
+	Expr result;
+	for (unsigned i = 0; i < array->getSize(); i++) {
+		auto byte = builder->Read(ul, builder->Constant(i, klee::Expr::Int32));
+		result = result.isNull() ? byte : builder->Concat(byte, result);
+	}
+
+	return result;
+}
+
+/* Build a random expression, the same generator state yields the same
+ * expression regardless of the builder. */
+static Expr
+generate(klee::ExprBuilder *builder, std::mt19937 &rng, unsigned depth)
+{
+	if (depth == 0 || rng() % 5 == 0) {
+		switch (rng() % 3) {
+		case 0:
+			return readWord(builder, vars[0]);
+		case 1:
+			return readWord(builder, vars[1]);
+		default: {
+			uint64_t value = (rng() % 3 == 0) ? 0 : rng();
+			return builder->Constant(value, 8 * (1 + rng() % 4));
+		}
+		}
+	}
+
+	auto e = generate(builder, rng, depth - 1);
+	auto width = e->getWidth();
+
+	switch (rng() % 4) {
+	case 0: {
+		if (width < 3)
+			return e;
+		unsigned w = 2 + rng() % (width - 2);
+		unsigned offset = rng() % (width - w + 1);
+		return builder->Extract(e, offset, w);
+	}
+	case 1: {
+		auto rhs = generate(builder, rng, depth - 1);
+		if (width + rhs->getWidth() > klee::Expr::Int64)
+			return e;
+		return builder->Concat(e, rhs);
+	}
+	case 2: {
+		unsigned w = width + 1 + rng() % (klee::Expr::Int64 - width + 1);
+		return (w > klee::Expr::Int64) ? e : builder->ZExt(e, w);
+	}
+	default: {
+		unsigned w = width + 1 + rng() % (klee::Expr::Int64 - width + 1);
+		return (w > klee::Expr::Int64) ? e : builder->SExt(e, w);
+	}
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned long iterations = DEFAULT_ITERATIONS;
+	if (argc > 1)
+		iterations = strtoul(argv[1], NULL, 10);
+
+	vars[0] = arrays.CreateArray("x", 4);
+	vars[1] = arrays.CreateArray("y", 4);
+
+	klee::ExprBuilder *reference = klee::createDefaultExprBuilder();
+	reference = klee::createConstantFoldingExprBuilder(reference);
+	reference = klee::createSimplifyingExprBuilder(reference);
+
+	klee::ExprBuilder *builder = klee::createDefaultExprBuilder();
+	builder = new HashConsingBuilder(builder);
+	builder = new ExtractFoldingBuilder(builder);
+	builder = klee::createConstantFoldingExprBuilder(builder);
+	builder = klee::createSimplifyingExprBuilder(builder);
+
+	Solver solver;
+	std::mt19937 seeds(1);
+
+	unsigned long failed = 0;
+	for (unsigned long i = 0; i < iterations; i++) {
+		auto seed = seeds();
+		std::mt19937 rng1(seed), rng2(seed);
+
+		auto expected = generate(reference, rng1, MAX_DEPTH);
+		auto actual = generate(builder, rng2, MAX_DEPTH);
+
+		bool equal = expected->getWidth() == actual->getWidth();
+		if (equal) {
+			klee::ConstraintSet cs;
+			equal = solver.eval(klee::Query(cs, klee::EqExpr::create(expected, actual)));
+		}
+
+		std::vector<klee::ref<klee::ReadExpr>> reads;
+		klee::findReads(actual, true, reads);
+		bool folded = !reads.empty() || klee::isa<klee::ConstantExpr>(actual);
+
+		if (!equal || !folded) {
+			std::cerr << "Check " << i << " failed (" << ((equal) ? "not folded" : "not equivalent") << "):" << std::endl;
+			expected->dump();
+			actual->dump();
+			failed++;
+		}
+	}
+
+	std::cout << iterations - failed << " / " << iterations << " checks passed" << std::endl;
+
+	delete builder;
+	delete reference;
+	return (failed) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
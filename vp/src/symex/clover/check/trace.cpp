@@ -0,0 +1,61 @@
+#include <iostream>
+
+#include <stdlib.h>
+
+#include <clover/clover.h>
+
+using namespace clover;
+
+/* Check of Trace::satisfiesAssume for stores which provide values
+ * for all, some, or none of the variables of the assumed constraints.
+ * Variables without a value in the store are unconstrained, a store
+ * is only rejected if a constraint is violated by its values. */
+
+struct Case {
+	const char *name;
+	std::optional<uint32_t> x, y;
+	bool expected;
+};
+
+static const Case cases[] = {
+	{"all variables, satisfied", 5, 3, true},
+	{"all variables, violated", 5, 4, false},
+	{"only x, satisfied", 5, std::nullopt, true},
+	{"only x, violated", 6, std::nullopt, false},
+	{"only y, satisfied", std::nullopt, 3, true},
+	{"no variables", std::nullopt, std::nullopt, true},
+};
+
+int
+main(void)
+{
+	Solver solver;
+	Trace trace(solver);
+
+	auto x = solver.BVC(std::string("x"), (uint32_t)0);
+	auto y = solver.BVC(std::string("y"), (uint32_t)0);
+	auto idx = solver.symbols.intern("x");
+	auto idy = solver.symbols.intern("y");
+
+	trace.assume(x->eq(solver.BVC(std::nullopt, (uint32_t)5))->symbolic.value());
+	trace.assume(y->eq(solver.BVC(std::nullopt, (uint32_t)3))->symbolic.value());
+
+	unsigned failed = 0;
+	for (auto &c : cases) {
+		ConcreteStore store;
+		if (c.x.has_value())
+			store.set(idx, *c.x);
+		if (c.y.has_value())
+			store.set(idy, *c.y);
+
+		if (trace.satisfiesAssume(store) != c.expected) {
+			std::cerr << "Check '" << c.name << "' failed" << std::endl;
+			failed++;
+		}
+	}
+
+	size_t total = sizeof(cases) / sizeof(cases[0]);
+	std::cout << total - failed << " / " << total << " checks passed" << std::endl;
+
+	return (failed) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
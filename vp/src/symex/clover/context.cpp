@@ -11,6 +11,12 @@ ExecutionContext::ExecutionContext(Solver &_solver)
 	return;
 }
 
+void
+ExecutionContext::seed(unsigned int seed)
+{
+	rng.seed(seed);
+}
+
 ConcreteStore
 ExecutionContext::getPrevStore(void)
 {
@@ -27,12 +33,12 @@ ExecutionContext::clear(void)
 bool
 ExecutionContext::setupNewValues(ConcreteStore store)
 {
-	for (auto assign : store) {
-		std::string name = assign.first;
-		IntValue value = assign.second;
+	for (SymbolID id = 0; id < store.limit(); id++) {
+		if (!store.has(id))
+			continue;
 
 		/* Cache value for next invocation of getSymbolic() */
-		next_run[name] = value;
+		next_run.set(id, store.get(id));
 	}
 
 	last_run.clear(); // Clear variable assignment of last run
@@ -40,9 +46,9 @@ ExecutionContext::setupNewValues(ConcreteStore store)
 }
 
 bool
-ExecutionContext::setupNewValues(unsigned k, Trace &trace)
+ExecutionContext::setupNewValues(unsigned k, Trace &trace, bool preferCurrent)
 {
-	auto assign = trace.findNewPath(k);
+	auto assign = trace.findNewPath(k, preferCurrent);
 	if (!assign.has_value())
 		return false;
 
@@ -52,8 +58,9 @@ ExecutionContext::setupNewValues(unsigned k, Trace &trace)
 std::shared_ptr<ConcolicValue>
 ExecutionContext::getSymbolicWord(std::string name)
 {
-	IntValue concrete = findRemoveOrRandom<uint32_t>(name);
-	return solver.BVC(name, concrete);
+	SymbolID id = solver.symbols.intern(name);
+	IntValue concrete = findRemoveOrRandom<uint32_t>(id);
+	return solver.BVC(id, concrete);
 }
 
 /* TODO: Possible optimization: Assume that memory passed to this
@@ -65,9 +72,9 @@ ExecutionContext::getSymbolicBytes(std::string name, size_t size)
 {
 	std::shared_ptr<ConcolicValue> result = nullptr;
 
+	auto &ids = solver.symbols.internBytes(name, size);
 	for (size_t i = 0; i < size; i++) {
-		std::string bname = name + ":byte" + std::to_string(i);
-		auto symbyte = getSymbolicByte(bname);
+		auto symbyte = getSymbolicByte(ids[i]);
 
 		if (!result) {
 			result = symbyte;
@@ -82,6 +89,12 @@ ExecutionContext::getSymbolicBytes(std::string name, size_t size)
 std::shared_ptr<ConcolicValue>
 ExecutionContext::getSymbolicByte(std::string name)
 {
-	IntValue concrete = findRemoveOrRandom<uint8_t>(name);
-	return solver.BVC(name, concrete); /* TODO: eternal=false? */
+	return getSymbolicByte(solver.symbols.intern(name));
+}
+
+std::shared_ptr<ConcolicValue>
+ExecutionContext::getSymbolicByte(SymbolID id)
+{
+	IntValue concrete = findRemoveOrRandom<uint8_t>(id);
+	return solver.BVC(id, concrete); /* TODO: eternal=false? */
 }
@@ -10,5 +10,6 @@
 size_t intByteSize(clover::IntValue v);
 uint64_t intToUint(clover::IntValue v);
 clover::IntValue intFromVector(std::vector<unsigned char> vector);
+std::vector<unsigned char> intToVector(clover::IntValue v);
 
 #endif
@@ -5,23 +5,101 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include <klee/ADT/RNG.h>
 #include <klee/Expr/ArrayCache.h>
 #include <klee/Expr/Assignment.h>
 #include <klee/Expr/Expr.h>
 #include <klee/Expr/ExprBuilder.h>
 #include <klee/Solver/Solver.h>
+#include <klee/Statistics/Statistic.h>
 #include <klee/Support/Casting.h>
 
 #include <fstream>
+#include <istream>
 #include <map>
 #include <memory>
 #include <optional>
+#include <ostream>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
 #include <variant>
+#include <vector>
 
 namespace clover {
 
+namespace stats {
+	/* Time spent constructing queries for negated branch conditions. */
+	extern klee::Statistic queryBuildTime;
+
+	/* Non-constant expressions constructed by the ExprBuilder, which
+	 * were already present (shared) or created (unique). */
+	extern klee::Statistic exprsShared;
+	extern klee::Statistic exprsUnique;
+
+	/* Conflicts learned from unsat queries of the path search, and
+	 * queries rejected due to a learned conflict (see Trace). */
+	extern klee::Statistic conflictsLearned;
+	extern klee::Statistic conflictsPruned;
+}
+
 typedef std::variant<uint8_t, uint32_t> IntValue;
 
+/* Dense identifier of a named symbolic variable (see SymbolTable). */
+typedef uint32_t SymbolID;
+
+/* Interns names of symbolic variables to dense integer identifiers.
+ * Identifiers are assigned once on creation of the variable, names
+ * are only required for test case input and output. */
+class SymbolTable {
+private:
+	std::unordered_map<std::string, SymbolID> ids;
+	std::vector<std::string> names;
+
+	/* KLEE array for each identifier, nullptr if not created yet. */
+	std::vector<const klee::Array *> arrays;
+	std::unordered_map<const klee::Array *, SymbolID> array_ids;
+
+	/* Identifiers of byte-wise variables (see internBytes) */
+	std::unordered_map<std::string, std::vector<SymbolID>> byte_ids;
+
+public:
+	SymbolID intern(const std::string &name);
+
+	/* Interns <name>:byte0 ... <name>:byte<size-1> and returns the
+	 * identifiers of all bytes. Names are only constructed on the
+	 * first invocation for a given name. The returned reference is
+	 * invalidated by the next invocation for the same name. */
+	const std::vector<SymbolID> &internBytes(const std::string &name, size_t size);
+
+	std::optional<SymbolID> lookup(const klee::Array *array) const;
+	const std::string &getName(SymbolID id) const;
+
+	const klee::Array *getArray(SymbolID id) const;
+	void setArray(SymbolID id, const klee::Array *array);
+};
+
+/* Assignment of concrete values to symbolic variables, stored as a
+ * flat vector indexed by the variable identifier. */
+class ConcreteStore {
+private:
+	std::vector<std::optional<IntValue>> values;
+	size_t count = 0;
+
+public:
+	bool empty(void) const { return count == 0; }
+	size_t size(void) const { return count; }
+
+	/* Upper bound (exclusive) for identifiers in this store. */
+	SymbolID limit(void) const { return (SymbolID)values.size(); }
+
+	bool has(SymbolID id) const;
+	const IntValue &get(SymbolID id) const;
+	void set(SymbolID id, IntValue value);
+	void erase(SymbolID id);
+	void clear(void);
+};
+
 /* Raised when a new assertion was added to the execution tree
  * and new values need to be determined for all concolic values
  * via ExecutionContext::setupNewValues(). */
@@ -104,22 +182,40 @@ private:
 	klee::ArrayCache array_cache;
 	klee::ExprBuilder *builder = NULL;
 
+	/* Parsed KQuery constraint where each variable of the
+	 * environment is represented by a placeholder array. */
+	struct Template {
+		klee::ref<klee::Expr> expr;
+		std::map<std::string, std::pair<const klee::Array *, klee::ref<klee::Expr>>> placeholders;
+	};
+
+	/* Templates keyed by KQuery string and environment shape */
+	std::unordered_map<std::string, Template> templates;
+
 public:
+	SymbolTable symbols;
+
 	Solver(klee::Solver *_solver = NULL);
 	~Solver(void);
 
 	void setTimeout(klee::time::Span timeout);
-	std::optional<klee::Assignment> getAssignment(const klee::Query &query);
+	/* Returns std::nullopt if the query is unsat or the solver failed,
+	 * the former is indicated through unsat (if given). */
+	std::optional<klee::Assignment> getAssignment(const klee::Query &query, bool *unsat = nullptr);
 
 	bool eval(const klee::Query &query);
 	std::shared_ptr<ConcolicValue> BVC(std::optional<std::string> name, IntValue value);
+	std::shared_ptr<ConcolicValue> BVC(SymbolID id, IntValue value);
+
+	/* Returns the array of the given variable, created on first use. */
+	const klee::Array *getArray(SymbolID id, size_t bytesize);
 
 	/* Methods for converting between concolic values and uint8_t buffers */
 	std::shared_ptr<ConcolicValue> BVC(uint8_t *buf, size_t buflen, bool lsb = false);
 	void BVCToBytes(std::shared_ptr<ConcolicValue> value, uint8_t *buf, size_t buflen);
 
 	typedef std::map<std::string, std::shared_ptr<BitVector>> Env;
-	std::shared_ptr<BitVector> fromString(Env env, std::string kquery);
+	std::shared_ptr<BitVector> fromString(const Env &env, const std::string &kquery);
 
 	template <typename T>
 	T evalValue(const klee::Query &query)
@@ -145,6 +241,66 @@ public:
 	}
 };
 
+/**
+ * Compact binary encoding of expressions and variable assignments,
+ * used to checkpoint the exploration state. Integers are written as
+ * LEB128 varints. Expressions are encoded as a DAG, i.e. shared
+ * subexpressions are only written once and referenced by index
+ * thereafter. Arrays are identified by the name of the symbolic
+ * variable and recreated through the SymbolTable when reading.
+ */
+class Serializer {
+private:
+	std::ostream &stream;
+	const SymbolTable &symbols;
+
+	std::unordered_map<const klee::Expr *, uint64_t> exprs;
+	std::unordered_map<const klee::UpdateNode *, uint64_t> updates;
+	std::unordered_map<const klee::Array *, uint64_t> arrays;
+
+	void writeArray(const klee::Array *array);
+	void writeUpdates(const klee::UpdateNode *node);
+
+public:
+	Serializer(std::ostream &_stream, const SymbolTable &_symbols);
+
+	void write(uint64_t value);
+	void write(const std::string &str);
+	void write(klee::ref<klee::Expr> expr);
+	void write(const ConcreteStore &store);
+};
+
+class Deserializer {
+public:
+	class Error : public std::runtime_error {
+	public:
+		Error(const std::string &msg)
+		    : std::runtime_error("invalid checkpoint: " + msg)
+		{
+			return;
+		}
+	};
+
+private:
+	std::istream &stream;
+	Solver &solver;
+
+	std::vector<klee::ref<klee::Expr>> exprs;
+	std::vector<klee::ref<klee::UpdateNode>> updates;
+	std::vector<const klee::Array *> arrays;
+
+	const klee::Array *readArray(void);
+	klee::ref<klee::UpdateNode> readUpdates(void);
+
+public:
+	Deserializer(std::istream &_stream, Solver &_solver);
+
+	uint64_t readInt(void);
+	std::string readString(void);
+	klee::ref<klee::Expr> readExpr(void);
+	ConcreteStore readStore(void);
+};
+
 class ConcolicMemory {
 private:
 	typedef uint32_t Addr;
@@ -163,8 +319,6 @@ public:
 	void store(std::shared_ptr<ConcolicValue> addr, std::shared_ptr<ConcolicValue> value, unsigned bytesize);
 };
 
-typedef std::map<std::string, IntValue> ConcreteStore;
-
 /**
  * The Tracer fullfills two tasks:
  *
@@ -231,19 +385,51 @@ private:
 		 * decides to negate the branch condition the path leads to.
 		 *
 		 * Returns false if no unnegated branch condition exists. */
-		bool randomUnnegated(unsigned k, Path &path);
+		bool randomUnnegated(unsigned k, Path &path, klee::RNG &rng);
 	};
 
+	/* Free the execution tree rooted at the given node. */
+	static void freeTree(Node *root);
+
 	Solver &solver;
+	klee::RNG rng;
 	klee::ConstraintSet cs;
 	klee::ConstraintManager cm;
 
+	/* Branch conditions of the current path which have not been added
+	 * to the constraint set yet. Adding a constraint simplifies it and
+	 * possibly all existing constraints, this is deferred until the
+	 * constraint set is required by getQuery(). */
+	std::vector<klee::ref<klee::Expr>> pending;
+
 	klee::ConstraintSet assume_cs;
 	klee::ConstraintManager assume_cm;
 
 	Node *pathCondsRoot;
 	Node *pathCondsCurrent;
 
+	/* Subsets of the constraints of unsat queries, which are unsat
+	 * in conjunction with the negated branch condition (last element),
+	 * keyed by the address of the branch. A query is rejected if it
+	 * contains a learned conflict of its branch. */
+	typedef std::vector<klee::ref<klee::Expr>> Conflict;
+	std::unordered_map<uint32_t, std::vector<Conflict>> conflicts;
+
+	void learnConflict(uint32_t addr, const klee::Query &query);
+	bool isConflicting(uint32_t addr, const klee::Query &query);
+
+	/* Nodes and branch conditions of the current path */
+	std::vector<Node *> currentNodes;
+	Path currentPath;
+
+	/* Branch conditions of the current path in dry-run mode, which
+	 * are only added to the execution tree by commit(). */
+	Path deferred;
+	bool dryRun = false;
+
+	/* Like Node::randomUnnegated but only considers nodes on the current path. */
+	bool currentUnnegated(unsigned k, Path &path);
+
 	/* Create new query for path in execution tree. */
 	klee::Query newQuery(klee::ConstraintSet &cs, Path &path);
 
@@ -255,20 +441,42 @@ public:
 	~Trace(void);
 	void reset(void);
 
+	/* Seed the random number generator used for path selection. */
+	void seed(unsigned int seed);
+
 	/* Add branch node to tree which can (potentially) be either true or false. */
 	void add(bool condition, std::shared_ptr<BitVector> bv, uint32_t pc, unsigned pktSeqLen);
 
+	/* In dry-run mode, branches of the current path are not added to
+	 * the execution tree unless the path is committed via commit().
+	 * Until then, the current path of the last committed run is
+	 * retained (see findNewPath). */
+	void setDryRun(bool enabled);
+	void commit(void);
+
 	/* Enforce the given constraint via the constraint manager */
 	void assume(std::shared_ptr<BitVector> costraint);
 
+	/* Whether the given store satisfies all assumed constraints,
+	 * variables without a value in the store are unconstrained. */
+	bool satisfiesAssume(const ConcreteStore &store);
+
 	/* … */
 	std::optional<klee::Assignment> fromAssume(void);
 
 	/* Create query from BitVector with currently tracked constraints. */
 	klee::Query getQuery(std::shared_ptr<BitVector> bv);
 
-	std::optional<klee::Assignment> findNewPath(unsigned k);
+	/* Find assignment for an undiscovered path. If preferCurrent is
+	 * true, unnegated branch conditions on the current path are
+	 * attempted first. */
+	std::optional<klee::Assignment> findNewPath(unsigned k, bool preferCurrent = false);
 	ConcreteStore getStore(const klee::Assignment &assign);
+
+	/* Save or restore the execution tree and assumed constraints.
+	 * Restoring replaces the current execution tree. */
+	void save(Serializer &out);
+	void load(Deserializer &in);
 };
 
 class ExecutionContext {
@@ -280,37 +488,73 @@ private:
 	ConcreteStore last_run;
 
 	Solver &solver;
+	klee::RNG rng;
 
 	template <typename T>
-	IntValue findRemoveOrRandom(std::string name)
+	IntValue findRemoveOrRandom(SymbolID id)
 	{
 		IntValue concrete;
 
-		auto iter = next_run.find(name);
-		if (iter != next_run.end()) {
-			concrete = (*iter).second;
+		if (next_run.has(id)) {
+			concrete = next_run.get(id);
 			assert(std::get_if<T>(&concrete) != nullptr);
-			next_run.erase(iter);
+			next_run.erase(id);
 		} else {
-			concrete = (T)rand();
+			concrete = (T)rng.getInt32();
 		}
 
-		last_run[name] = concrete;
+		last_run.set(id, concrete);
 		return concrete;
 	}
 
 public:
 	ExecutionContext(Solver &_solver);
 
+	/* Seed the random number generator used for unassigned variables. */
+	void seed(unsigned int seed);
+
 	void clear(void);
 	ConcreteStore getPrevStore(void);
 
 	bool setupNewValues(ConcreteStore store);
-	bool setupNewValues(unsigned k, Trace &trace);
+	bool setupNewValues(unsigned k, Trace &trace, bool preferCurrent = false);
 
 	std::shared_ptr<ConcolicValue> getSymbolicWord(std::string name);
 	std::shared_ptr<ConcolicValue> getSymbolicBytes(std::string name, size_t size);
 	std::shared_ptr<ConcolicValue> getSymbolicByte(std::string name);
+	std::shared_ptr<ConcolicValue> getSymbolicByte(SymbolID id);
+};
+
+/* Creates concrete mutations of previously explored inputs, which can
+ * be executed without invoking the solver. Mutations are stacked bit
+ * flips, byte substitutions, and insertions of dictionary tokens. */
+class Mutator {
+private:
+	/* Value for a sequence of byte variables (least significant first) */
+	typedef std::pair<std::vector<SymbolID>, uint64_t> Token;
+
+	std::vector<Token> tokens;
+	std::set<Token> known_tokens;
+
+	/* Recently explored inputs, the oldest input is replaced once
+	 * the maximum number of seeds is exceeded. */
+	std::vector<ConcreteStore> seeds;
+	size_t next_seed = 0;
+
+	klee::RNG rng;
+
+	void mutateValue(ConcreteStore &store, SymbolID id);
+	void insertToken(ConcreteStore &store);
+
+public:
+	/* Seed the random number generator used for mutations. */
+	void seed(unsigned int seed);
+
+	void addSeed(const ConcreteStore &store);
+	void addToken(const std::vector<SymbolID> &ids, uint64_t value);
+
+	/* Returns a mutation of a random seed, requires at least one seed. */
+	ConcreteStore mutate(void);
 };
 
 class TestCase {
@@ -332,8 +576,8 @@ class TestCase {
 	};
 
 public:
-	static ConcreteStore fromFile(std::string name, std::ifstream &stream);
-	static void toFile(ConcreteStore store, std::ofstream &stream);
+	static ConcreteStore fromFile(SymbolTable &symbols, std::string name, std::ifstream &stream);
+	static void toFile(const SymbolTable &symbols, const ConcreteStore &store, std::ofstream &stream);
 };
 
 }; // namespace clover
@@ -58,3 +58,12 @@ intFromVector(std::vector<unsigned char> vector)
 
 	return intval;
 }
+
+std::vector<unsigned char>
+intToVector(IntValue v)
+{
+	std::vector<unsigned char> vector(intByteSize(v));
+	std::visit([&](auto value) { memcpy(&vector[0], &value, sizeof(value)); }, v);
+
+	return vector;
+}
@@ -0,0 +1,97 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include <clover/clover.h>
+
+#include "fns.h"
+
+using namespace clover;
+
+/* Maximum number of seeds retained for mutation */
+#define MAX_SEEDS 32
+
+/* Maximum number of mutations applied to a single seed */
+#define MAX_STACKED 4
+
+/* Byte values commonly triggering edge cases, as used by AFL */
+static const uint8_t interesting[] = { 0x00, 0x01, 0x7f, 0x80, 0xff };
+
+void
+Mutator::seed(unsigned int seed)
+{
+	rng.seed(seed);
+}
+
+void
+Mutator::addSeed(const ConcreteStore &store)
+{
+	if (store.empty())
+		return;
+
+	if (seeds.size() < MAX_SEEDS) {
+		seeds.push_back(store);
+	} else {
+		seeds.at(next_seed) = store;
+		next_seed = (next_seed + 1) % MAX_SEEDS;
+	}
+}
+
+void
+Mutator::addToken(const std::vector<SymbolID> &ids, uint64_t value)
+{
+	auto token = std::make_pair(ids, value);
+	if (known_tokens.insert(token).second)
+		tokens.push_back(token);
+}
+
+void
+Mutator::mutateValue(ConcreteStore &store, SymbolID id)
+{
+	auto value = intToUint(store.get(id));
+	auto width = intByteSize(store.get(id)) * 8;
+
+	if (rng.getBool()) {
+		value ^= 1ULL << (rng.getInt32() % width);
+	} else {
+		// Substitute a random byte of the value.
+		auto shift = (rng.getInt32() % (width / 8)) * 8;
+		auto byte = (rng.getBool()) ? interesting[rng.getInt32() % sizeof(interesting)] : (uint8_t)rng.getInt32();
+		value = (value & ~(0xffULL << shift)) | ((uint64_t)byte << shift);
+	}
+
+	if (std::get_if<uint8_t>(&store.get(id)))
+		store.set(id, (uint8_t)value);
+	else
+		store.set(id, (uint32_t)value);
+}
+
+void
+Mutator::insertToken(ConcreteStore &store)
+{
+	auto &token = tokens.at(rng.getInt32() % tokens.size());
+	for (size_t i = 0; i < token.first.size(); i++)
+		store.set(token.first[i], (uint8_t)(token.second >> (i * 8)));
+}
+
+ConcreteStore
+Mutator::mutate(void)
+{
+	assert(!seeds.empty());
+	ConcreteStore store = seeds.at(rng.getInt32() % seeds.size());
+
+	std::vector<SymbolID> ids;
+	for (SymbolID id = 0; id < store.limit(); id++) {
+		if (store.has(id))
+			ids.push_back(id);
+	}
+
+	unsigned stacked = 1 + rng.getInt32() % MAX_STACKED;
+	for (unsigned i = 0; i < stacked; i++) {
+		if (!tokens.empty() && rng.getInt32() % 3 == 0)
+			insertToken(store);
+		else
+			mutateValue(store, ids.at(rng.getInt32() % ids.size()));
+	}
+
+	return store;
+}
@@ -23,7 +23,7 @@ Trace::Node::isPlaceholder(void)
 }
 
 bool
-Trace::Node::randomUnnegated(unsigned k, Path &path)
+Trace::Node::randomUnnegated(unsigned k, Path &path, klee::RNG &rng)
 {
 	// TODO: Consider traversing tree iteratively instead of
 	// recursively. Otherwise, we might ran into a stack
@@ -39,19 +39,19 @@ Trace::Node::randomUnnegated(unsigned k, Path &path)
 	size_t idx = path.size() - 1;
 
 	/* Randomly traverse true or false branch first */
-	if (rand() % 2 == 0) {
-		if (CHECK_BRANCH(true_branch, k, path)) {
+	if (rng.getBool()) {
+		if (CHECK_BRANCH(true_branch, k, path, rng)) {
 			path[idx].second = true;
 			return true;
-		} else if (CHECK_BRANCH(false_branch, k, path)) {
+		} else if (CHECK_BRANCH(false_branch, k, path, rng)) {
 			path[idx].second = false;
 			return true;
 		}
 	} else {
-		if (CHECK_BRANCH(false_branch, k, path)) {
+		if (CHECK_BRANCH(false_branch, k, path, rng)) {
 			path[idx].second = false;
 			return true;
-		} else if (CHECK_BRANCH(true_branch, k, path)) {
+		} else if (CHECK_BRANCH(true_branch, k, path, rng)) {
 			path[idx].second = true;
 			return true;
 		}
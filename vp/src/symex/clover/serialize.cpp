@@ -0,0 +1,322 @@
+#include <assert.h>
+#include <stdint.h>
+
+#include <clover/clover.h>
+
+#include "fns.h"
+
+using namespace clover;
+
+/* Tag of an IntValue in a serialized ConcreteStore */
+enum {
+	INTVAL_UINT8 = 0,
+	INTVAL_UINT32 = 1,
+};
+
+/* Objects which were already written are referenced by their index,
+ * the least significant bit distinguishes references from definitions */
+#define REFERENCE(IDX) (((IDX) << 1) | 1)
+#define DEFINITION ((uint64_t)0)
+
+Serializer::Serializer(std::ostream &_stream, const SymbolTable &_symbols)
+    : stream(_stream), symbols(_symbols)
+{
+	return;
+}
+
+void
+Serializer::write(uint64_t value)
+{
+	do {
+		uint8_t byte = value & 0x7f;
+		value >>= 7;
+		if (value)
+			byte |= 0x80;
+		stream.put(byte);
+	} while (value);
+}
+
+void
+Serializer::write(const std::string &str)
+{
+	write((uint64_t)str.size());
+	stream.write(str.data(), str.size());
+}
+
+void
+Serializer::writeArray(const klee::Array *array)
+{
+	auto iter = arrays.find(array);
+	if (iter != arrays.end()) {
+		write(REFERENCE(iter->second));
+		return;
+	}
+
+	assert(array->isSymbolicArray() && "constant arrays are not supported");
+
+	auto id = symbols.lookup(array);
+	write(DEFINITION);
+	write((id.has_value()) ? symbols.getName(*id) : array->getName());
+	write((uint64_t)array->getSize());
+
+	size_t idx = arrays.size();
+	arrays[array] = idx;
+}
+
+void
+Serializer::writeUpdates(const klee::UpdateNode *node)
+{
+	if (!node) {
+		write(REFERENCE(0)); // Index zero is reserved for empty list
+		return;
+	}
+
+	auto iter = updates.find(node);
+	if (iter != updates.end()) {
+		write(REFERENCE(iter->second));
+		return;
+	}
+
+	write(DEFINITION);
+	writeUpdates(node->next.get());
+	write(node->index);
+	write(node->value);
+
+	size_t idx = updates.size() + 1;
+	updates[node] = idx;
+}
+
+void
+Serializer::write(klee::ref<klee::Expr> expr)
+{
+	auto iter = exprs.find(expr.get());
+	if (iter != exprs.end()) {
+		write(REFERENCE(iter->second));
+		return;
+	}
+
+	write(DEFINITION);
+	write((uint64_t)expr->getKind());
+
+	switch (expr->getKind()) {
+	case klee::Expr::Constant: {
+		auto ce = klee::cast<klee::ConstantExpr>(expr);
+		auto &value = ce->getAPValue();
+
+		write((uint64_t)ce->getWidth());
+		for (unsigned i = 0; i < value.getNumWords(); i++)
+			write(value.getRawData()[i]);
+	} break;
+	case klee::Expr::Read: {
+		auto re = klee::cast<klee::ReadExpr>(expr);
+		writeArray(re->updates.root);
+		writeUpdates(re->updates.head.get());
+		write(re->index);
+	} break;
+	case klee::Expr::Extract: {
+		auto ee = klee::cast<klee::ExtractExpr>(expr);
+		write(ee->expr);
+		write((uint64_t)ee->offset);
+		write((uint64_t)ee->width);
+	} break;
+	case klee::Expr::ZExt:
+	case klee::Expr::SExt:
+		write(expr->getKid(0));
+		write((uint64_t)expr->getWidth());
+		break;
+	default:
+		for (unsigned i = 0; i < expr->getNumKids(); i++)
+			write(expr->getKid(i));
+		break;
+	}
+
+	size_t idx = exprs.size();
+	exprs[expr.get()] = idx;
+}
+
+void
+Serializer::write(const ConcreteStore &store)
+{
+	write((uint64_t)store.size());
+	for (SymbolID id = 0; id < store.limit(); id++) {
+		if (!store.has(id))
+			continue;
+
+		IntValue value = store.get(id);
+		write(symbols.getName(id));
+		write((uint64_t)((std::get_if<uint8_t>(&value)) ? INTVAL_UINT8 : INTVAL_UINT32));
+		write(intToUint(value));
+	}
+}
+
+Deserializer::Deserializer(std::istream &_stream, Solver &_solver)
+    : stream(_stream), solver(_solver)
+{
+	updates.push_back(nullptr); // empty update list, see writeUpdates
+}
+
+uint64_t
+Deserializer::readInt(void)
+{
+	uint64_t value = 0;
+	for (unsigned shift = 0; shift < 64; shift += 7) {
+		int byte = stream.get();
+		if (byte == EOF)
+			throw Error("unexpected end of file");
+
+		value |= (uint64_t)(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return value;
+	}
+
+	throw Error("integer overflow");
+}
+
+std::string
+Deserializer::readString(void)
+{
+	std::string str(readInt(), '\0');
+	if (!stream.read(&str[0], str.size()))
+		throw Error("unexpected end of file");
+
+	return str;
+}
+
+const klee::Array *
+Deserializer::readArray(void)
+{
+	uint64_t tag = readInt();
+	if (tag != DEFINITION) {
+		if ((tag >> 1) >= arrays.size())
+			throw Error("unknown array");
+		return arrays.at(tag >> 1);
+	}
+
+	auto name = readString();
+	auto size = readInt();
+
+	auto id = solver.symbols.intern(name);
+	auto array = solver.symbols.getArray(id);
+	if (array && array->getSize() != size)
+		throw Error("size mismatch for array " + name);
+
+	array = solver.getArray(id, size);
+	arrays.push_back(array);
+	return array;
+}
+
+klee::ref<klee::UpdateNode>
+Deserializer::readUpdates(void)
+{
+	uint64_t tag = readInt();
+	if (tag != DEFINITION) {
+		if ((tag >> 1) >= updates.size())
+			throw Error("unknown update node");
+		return updates.at(tag >> 1);
+	}
+
+	auto next = readUpdates();
+	auto index = readExpr();
+	auto value = readExpr();
+
+	klee::ref<klee::UpdateNode> node = new klee::UpdateNode(next, index, value);
+	updates.push_back(node);
+	return node;
+}
+
+klee::ref<klee::Expr>
+Deserializer::readExpr(void)
+{
+	uint64_t tag = readInt();
+	if (tag != DEFINITION) {
+		if ((tag >> 1) >= exprs.size())
+			throw Error("unknown expression");
+		return exprs.at(tag >> 1);
+	}
+
+	klee::ref<klee::Expr> expr;
+	auto kind = (klee::Expr::Kind)readInt();
+
+	switch (kind) {
+	case klee::Expr::Constant: {
+		auto width = (klee::Expr::Width)readInt();
+
+		std::vector<uint64_t> words((width + 63) / 64);
+		for (auto &word : words)
+			word = readInt();
+
+		expr = klee::ConstantExpr::alloc(llvm::APInt(width, words));
+	} break;
+	case klee::Expr::Read: {
+		auto root = readArray();
+		auto head = readUpdates();
+		auto index = readExpr();
+
+		expr = klee::ReadExpr::create(klee::UpdateList(root, head), index);
+	} break;
+	case klee::Expr::Extract: {
+		auto kid = readExpr();
+		auto offset = (unsigned)readInt();
+		auto width = (klee::Expr::Width)readInt();
+
+		expr = klee::ExtractExpr::create(kid, offset, width);
+	} break;
+	case klee::Expr::Not:
+		expr = klee::NotExpr::create(readExpr());
+		break;
+	case klee::Expr::NotOptimized:
+		expr = klee::NotOptimizedExpr::create(readExpr());
+		break;
+	case klee::Expr::ZExt:
+	case klee::Expr::SExt: {
+		auto kid = readExpr();
+		auto width = (klee::Expr::Width)readInt();
+
+		expr = klee::Expr::createFromKind(kind, {kid, width});
+	} break;
+	case klee::Expr::Select: {
+		auto cond = readExpr();
+		auto texpr = readExpr();
+		auto fexpr = readExpr();
+
+		expr = klee::SelectExpr::create(cond, texpr, fexpr);
+	} break;
+	default: {
+		if (kind != klee::Expr::Concat && (kind < klee::Expr::BinaryKindFirst || kind > klee::Expr::BinaryKindLast))
+			throw Error("unknown expression kind");
+
+		auto lhs = readExpr();
+		auto rhs = readExpr();
+		expr = klee::Expr::createFromKind(kind, {lhs, rhs});
+	} break;
+	}
+
+	exprs.push_back(expr);
+	return expr;
+}
+
+ConcreteStore
+Deserializer::readStore(void)
+{
+	ConcreteStore store;
+
+	auto size = readInt();
+	for (uint64_t i = 0; i < size; i++) {
+		auto id = solver.symbols.intern(readString());
+		auto type = readInt();
+		auto value = readInt();
+
+		switch (type) {
+		case INTVAL_UINT8:
+			store.set(id, (uint8_t)value);
+			break;
+		case INTVAL_UINT32:
+			store.set(id, (uint32_t)value);
+			break;
+		default:
+			throw Error("unknown value type");
+		}
+	}
+
+	return store;
+}
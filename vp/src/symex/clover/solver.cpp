@@ -5,9 +5,12 @@
 
 #include <klee/Expr/Constraints.h>
 #include <klee/Expr/ExprUtil.h>
+#include <klee/Expr/ExprVisitor.h>
 #include <klee/Expr/Parser/Parser.h>
+#include <klee/Solver/SolverImpl.h>
 #include <llvm/Support/MemoryBuffer.h>
 
+#include "builder.h"
 #include "fns.h"
 
 using namespace clover;
@@ -24,8 +27,11 @@ Solver::Solver(klee::Solver *_solver)
 	_solver = klee::createCachingSolver(_solver);
 	_solver = klee::createIndependentSolver(_solver);
 
-	// Copied from tools/kleaver/main.cpp
+	// Copied from tools/kleaver/main.cpp, expressions constructed by
+	// all layers are interned by the hash-consing layer.
 	builder = klee::createDefaultExprBuilder();
+	builder = new HashConsingBuilder(builder);
+	builder = new ExtractFoldingBuilder(builder);
 	builder = createConstantFoldingExprBuilder(builder);
 	builder = createSimplifyingExprBuilder(builder);
 
@@ -46,7 +52,7 @@ Solver::setTimeout(klee::time::Span timeout)
 }
 
 std::optional<klee::Assignment>
-Solver::getAssignment(const klee::Query &query)
+Solver::getAssignment(const klee::Query &query, bool *unsat)
 {
 	/* KLEE is concerned with validity of queries. To find a
 	 * statisfiable assignment for a query it needs to be negated. */
@@ -62,12 +68,21 @@ Solver::getAssignment(const klee::Query &query)
 	// and return if it is. Otherwise triggers an assert statement
 	// in the getAllIndependentConstraintsSets function.
 	auto ce = klee::dyn_cast<klee::ConstantExpr>(nq.expr);
-	if (ce && ce->isTrue())
+	if (ce && ce->isTrue()) {
+		if (unsat)
+			*unsat = true;
 		return std::nullopt;
+	}
 
+	// Use the SolverImpl directly, klee::Solver::getInitialValues()
+	// does not distinguish unsat queries from solver failures.
+	bool hasSolution = false;
 	std::vector<std::vector<unsigned char>> values;
-	if (!solver->getInitialValues(nq, objects, values))
-		return std::nullopt; /* unsat */
+	bool success = solver->impl->computeInitialValues(nq, objects, values, hasSolution);
+	if (unsat)
+		*unsat = success && !hasSolution;
+	if (!success || !hasSolution)
+		return std::nullopt;
 
 	return klee::Assignment(objects, values);
 }
@@ -102,13 +117,50 @@ Solver::BVC(std::optional<std::string> name, IntValue value)
 		return std::make_shared<ConcolicValue>(concolic);
 	}
 
-	auto array = array_cache.CreateArray(*name, intByteSize(value));
-	auto symbolic = std::make_shared<BitVector>(BitVector(array));
+	return BVC(symbols.intern(*name), value);
+}
+
+/* Equivalent to klee::Expr::createTempRead(), but constructs the
+ * expression using the builder. Thereby, the reads of an array are
+ * interned and shared by all values referring to the array. */
+static klee::ref<klee::Expr>
+readArray(klee::ExprBuilder *builder, const klee::Array *array)
+{
+	klee::UpdateList ul(array, 0);
+
+	klee::ref<klee::Expr> result;
+	for (unsigned i = 0; i < array->getSize(); i++) {
+		auto byte = builder->Read(ul, builder->Constant(i, klee::Expr::Int32));
+		result = result.isNull() ? byte : builder->Concat(byte, result);
+	}
+
+	return result;
+}
+
+std::shared_ptr<ConcolicValue>
+Solver::BVC(SymbolID id, IntValue value)
+{
+	auto concrete = std::make_shared<BitVector>(BitVector(value));
+	auto array = getArray(id, intByteSize(value));
+	auto symbolic = std::make_shared<BitVector>(BitVector(readArray(builder, array)));
 
 	auto concolic = ConcolicValue(builder, concrete, symbolic);
 	return std::make_shared<ConcolicValue>(concolic);
 }
 
+const klee::Array *
+Solver::getArray(SymbolID id, size_t bytesize)
+{
+	auto array = symbols.getArray(id);
+	if (!array) {
+		array = array_cache.CreateArray(symbols.getName(id), bytesize);
+		symbols.setArray(id, array);
+	}
+
+	assert(array->getSize() == bytesize);
+	return array;
+}
+
 std::shared_ptr<ConcolicValue>
 Solver::BVC(uint8_t *buf, size_t buflen, bool lsb)
 {
@@ -141,16 +193,90 @@ Solver::BVCToBytes(std::shared_ptr<ConcolicValue> value, uint8_t *buf, size_t bu
 	}
 }
 
+/* Replaces placeholder expressions, or reads from the underlying
+ * placeholder arrays, with the corresponding expressions from the
+ * environment (see Solver::fromString). */
+class PlaceholderVisitor : public klee::ExprVisitor {
+public:
+	std::map<klee::ref<klee::Expr>, klee::ref<klee::Expr>> exprs;
+	std::map<const klee::Array *, klee::ref<klee::Expr>> bytes;
+
+protected:
+	Action visitExpr(const klee::Expr &e) override
+	{
+		auto it = exprs.find(klee::ref<klee::Expr>(const_cast<klee::Expr *>(&e)));
+		if (it == exprs.end())
+			return Action::doChildren();
+		return Action::changeTo(it->second);
+	}
+
+	Action visitRead(const klee::ReadExpr &re) override
+	{
+		auto it = bytes.find(re.updates.root);
+		if (it == bytes.end())
+			return Action::doChildren();
+
+		auto idx = klee::dyn_cast<klee::ConstantExpr>(re.index);
+		assert(idx && "placeholder read with symbolic index");
+
+		auto off = (unsigned)idx->getZExtValue() * 8;
+		return Action::changeTo(klee::ExtractExpr::create(it->second, off, klee::Expr::Int8));
+	}
+};
+
 std::shared_ptr<BitVector>
-Solver::fromString(Env env, std::string kquery)
+Solver::fromString(const Env &env, const std::string &kquery)
 {
-	auto mb = llvm::MemoryBuffer::getMemBuffer(kquery.c_str());
-	auto par = klee::expr::Parser::Create(__FUNCTION__, mb.get(), builder, false);
+	// The parsed expression only depends on the KQuery string
+	// and the width of the variables in the environment.
+	std::string key = kquery;
+	for (auto &p : env)
+		key += '\0' + p.first + ':' + std::to_string(p.second->expr->getWidth());
+
+	auto it = templates.find(key);
+	if (it == templates.end()) {
+		Template tmpl;
+		std::map<std::string, klee::expr::ExprHandle> vars;
+
+		for (auto &p : env) {
+			auto width = p.second->expr->getWidth();
+			auto bytes = (width + 7) / 8;
+
+			std::string name = "tmpl" + std::to_string(templates.size()) + ":" + p.first;
+			auto array = array_cache.CreateArray(name, bytes);
 
-	std::map<std::string, klee::expr::ExprHandle> vars;
-	for (auto p : env)
-		vars[p.first] = p.second->expr;
+			auto expr = klee::Expr::createTempRead(array, bytes * 8);
+			if (expr->getWidth() != width)
+				expr = klee::ExtractExpr::create(expr, 0, width);
+
+			vars[p.first] = expr;
+			tmpl.placeholders[p.first] = std::make_pair(array, expr);
+		}
+
+		auto mb = llvm::MemoryBuffer::getMemBuffer(kquery.c_str());
+		auto par = klee::expr::Parser::Create(__FUNCTION__, mb.get(), builder, false);
+		tmpl.expr = par->ParseSingleConstraint(vars);
+
+		it = templates.emplace(key, tmpl).first;
+	}
+
+	const Template &tmpl = it->second;
+	if (tmpl.expr.isNull())
+		return std::make_shared<BitVector>(BitVector(tmpl.expr));
+
+	PlaceholderVisitor visitor;
+	for (auto &p : tmpl.placeholders) {
+		auto array = p.second.first;
+		auto value = env.at(p.first)->expr;
+		visitor.exprs[p.second.second] = value;
+
+		// Placeholder may have been rewritten by the ExprBuilder.
+		auto width = array->getSize() * 8;
+		if (value->getWidth() != width)
+			value = klee::ZExtExpr::create(value, width);
+		visitor.bytes[array] = value;
+	}
 
-	auto expr = par->ParseSingleConstraint(vars);
+	auto expr = visitor.visit(tmpl.expr);
 	return std::make_shared<BitVector>(BitVector(expr));
 }
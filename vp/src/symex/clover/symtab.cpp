@@ -0,0 +1,101 @@
+#include <assert.h>
+
+#include <clover/clover.h>
+
+using namespace clover;
+
+SymbolID
+SymbolTable::intern(const std::string &name)
+{
+	auto iter = ids.find(name);
+	if (iter != ids.end())
+		return iter->second;
+
+	SymbolID id = (SymbolID)names.size();
+	ids[name] = id;
+	names.push_back(name);
+	arrays.push_back(nullptr);
+
+	return id;
+}
+
+const std::vector<SymbolID> &
+SymbolTable::internBytes(const std::string &name, size_t size)
+{
+	auto &bytes = byte_ids[name];
+	for (size_t i = bytes.size(); i < size; i++)
+		bytes.push_back(intern(name + ":byte" + std::to_string(i)));
+
+	return bytes;
+}
+
+std::optional<SymbolID>
+SymbolTable::lookup(const klee::Array *array) const
+{
+	auto iter = array_ids.find(array);
+	if (iter == array_ids.end())
+		return std::nullopt;
+	return iter->second;
+}
+
+const std::string &
+SymbolTable::getName(SymbolID id) const
+{
+	return names.at(id);
+}
+
+const klee::Array *
+SymbolTable::getArray(SymbolID id) const
+{
+	return arrays.at(id);
+}
+
+void
+SymbolTable::setArray(SymbolID id, const klee::Array *array)
+{
+	assert(arrays.at(id) == nullptr);
+
+	arrays.at(id) = array;
+	array_ids[array] = id;
+}
+
+bool
+ConcreteStore::has(SymbolID id) const
+{
+	return id < values.size() && values[id].has_value();
+}
+
+const IntValue &
+ConcreteStore::get(SymbolID id) const
+{
+	assert(has(id));
+	return *values[id];
+}
+
+void
+ConcreteStore::set(SymbolID id, IntValue value)
+{
+	if (id >= values.size())
+		values.resize(id + 1);
+
+	if (!values[id].has_value())
+		count++;
+	values[id] = value;
+}
+
+void
+ConcreteStore::erase(SymbolID id)
+{
+	if (!has(id))
+		return;
+
+	values[id].reset();
+	count--;
+}
+
+void
+ConcreteStore::clear(void)
+{
+	values.clear();
+	count = 0;
+}
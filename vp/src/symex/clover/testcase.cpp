@@ -1,10 +1,10 @@
 #include <fstream>
 #include <iostream>
-#include <regex>
 
 #include <assert.h>
-#include <inttypes.h>
+#include <errno.h>
 #include <stdint.h>
+#include <stdlib.h>
 
 #include <clover/clover.h>
 using namespace clover;
@@ -15,34 +15,33 @@ typedef enum {
 	UINT32,
 } AssignType;
 
-#define PARSE_INT(STR, FMT, TYPE)                    \
-	{                                            \
-		TYPE v;                              \
-		int r = sscanf(STR, "%" FMT "", &v); \
-                                                     \
-		if (r == 1)                          \
-			return (TYPE)v;              \
-		else                                 \
-			return std::nullopt;         \
-	}
-
 static std::optional<IntValue>
-parseIntVal(AssignType type, std::string input)
+parseIntVal(AssignType type, const std::string &input)
 {
+	if (input.empty() || input.find_first_not_of("0123456789") != std::string::npos)
+		return std::nullopt;
+
+	errno = 0;
+	unsigned long long v = strtoull(input.c_str(), NULL, 10);
+	if (errno)
+		return std::nullopt;
+
 	switch (type) {
 	case UINT8:
-		PARSE_INT(input.c_str(), SCNu8, uint8_t);
-		break;
+		if (v > UINT8_MAX)
+			return std::nullopt;
+		return (uint8_t)v;
 	case UINT32:
-		PARSE_INT(input.c_str(), SCNu32, uint32_t);
-		break;
+		if (v > UINT32_MAX)
+			return std::nullopt;
+		return (uint32_t)v;
 	}
 
 	return std::nullopt;
 }
 
 static std::optional<AssignType>
-parseAssignType(std::string type)
+parseAssignType(const std::string &type)
 {
 	if (type == "uint8_t") {
 		return UINT8;
@@ -53,33 +52,31 @@ parseAssignType(std::string type)
 	}
 }
 
+/* Parses a line of the form <name>\t<type>\t<value>. The name
+ * itself may contain tab characters, hence split from the end. */
 static std::optional<Assignment>
-parseAssign(std::string assign)
+parseAssign(const std::string &assign)
 {
-	std::regex re("(..*)	(uint8_t|uint32_t)	([0-9][0-9]*)");
-
-	std::smatch match;
-	if (regex_search(assign, match, re)) {
-		if (match.size() != 4) /* match includes the entire string */
-			return std::nullopt;
-
-		auto name = match[1].str();
-		auto type = parseAssignType(match[2].str());
-		if (!type.has_value())
-			return std::nullopt;
+	size_t vpos = assign.rfind('\t');
+	if (vpos == std::string::npos || vpos == 0)
+		return std::nullopt;
+	size_t tpos = assign.rfind('\t', vpos - 1);
+	if (tpos == std::string::npos || tpos == 0)
+		return std::nullopt;
 
-		auto ival = parseIntVal(*type, match[3].str());
-		if (!ival.has_value())
-			return std::nullopt;
+	auto type = parseAssignType(assign.substr(tpos + 1, vpos - tpos - 1));
+	if (!type.has_value())
+		return std::nullopt;
 
-		return std::make_pair(name, *ival);
-	}
+	auto ival = parseIntVal(*type, assign.substr(vpos + 1));
+	if (!ival.has_value())
+		return std::nullopt;
 
-	return std::nullopt;
+	return std::make_pair(assign.substr(0, tpos), *ival);
 }
 
 ConcreteStore
-TestCase::fromFile(std::string name, std::ifstream &stream)
+TestCase::fromFile(SymbolTable &symbols, std::string name, std::ifstream &stream)
 {
 	ConcreteStore assigns;
 
@@ -92,7 +89,7 @@ TestCase::fromFile(std::string name, std::ifstream &stream)
 			throw TestCase::ParserError(name, lineNum, "invalid assignment");
 		}
 
-		assigns[std::get<0>(*assign)] = std::get<1>(*assign);
+		assigns.set(symbols.intern(std::get<0>(*assign)), std::get<1>(*assign));
 		lineNum++;
 	}
 
@@ -100,13 +97,20 @@ TestCase::fromFile(std::string name, std::ifstream &stream)
 }
 
 void
-TestCase::toFile(ConcreteStore store, std::ofstream &stream)
+TestCase::toFile(const SymbolTable &symbols, const ConcreteStore &store, std::ofstream &stream)
 {
-	for (auto assign : store) {
+	// Output assignments ordered by variable name.
+	std::map<std::string, SymbolID> order;
+	for (SymbolID id = 0; id < store.limit(); id++) {
+		if (store.has(id))
+			order[symbols.getName(id)] = id;
+	}
+
+	for (auto assign : order) {
 		// Output variable name
 		stream << assign.first << "\t";
 
-		IntValue v = assign.second;
+		IntValue v = store.get(assign.second);
 		if (std::get_if<uint8_t>(&v)) {
 			stream << "uint8_t\t" << std::dec << +std::get<uint8_t>(v);
 		} else if (std::get_if<uint32_t>(&v)) {
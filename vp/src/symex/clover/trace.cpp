@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <queue>
+#include <set>
 
 #include <assert.h>
 #include <stddef.h>
@@ -8,12 +10,69 @@
 
 #include <clover/clover.h>
 #include <klee/Expr/Constraints.h>
+#include <klee/Expr/ExprHashMap.h>
 #include <klee/Expr/ExprUtil.h>
+#include <klee/Statistics/TimerStatIncrementer.h>
 
 #include "fns.h"
 
 using namespace clover;
 
+klee::Statistic stats::queryBuildTime("QueryBuildTime", "QBtime");
+klee::Statistic stats::conflictsLearned("ConflictsLearned", "Clearned");
+klee::Statistic stats::conflictsPruned("ConflictsPruned", "Cpruned");
+
+/* Maximum number of learned conflicts per branch, older conflicts are
+ * replaced once it is exceeded. */
+#define MAX_CONFLICTS 16
+
+/* Bytes of symbolic arrays read by a set of expressions. Reads with a
+ * symbolic index, or from updated arrays, refer to the entire array. */
+class Footprint {
+private:
+	std::set<std::pair<const klee::Array *, uint64_t>> bytes;
+	std::set<const klee::Array *> arrays;
+
+public:
+	Footprint(klee::ref<klee::Expr> e)
+	{
+		std::vector<klee::ref<klee::ReadExpr>> reads;
+		klee::findReads(e, true, reads);
+
+		for (auto &re : reads) {
+			auto idx = klee::dyn_cast<klee::ConstantExpr>(re->index);
+			if (!idx || re->updates.head)
+				arrays.insert(re->updates.root);
+			else
+				bytes.insert(std::make_pair(re->updates.root, idx->getZExtValue()));
+		}
+	}
+
+	bool intersects(const Footprint &other) const
+	{
+		for (auto a : other.arrays) {
+			if (arrays.count(a))
+				return true;
+		}
+		for (auto &b : other.bytes) {
+			if (bytes.count(b) || arrays.count(b.first))
+				return true;
+		}
+		for (auto &b : bytes) {
+			if (other.arrays.count(b.first))
+				return true;
+		}
+
+		return false;
+	}
+
+	void merge(const Footprint &other)
+	{
+		bytes.insert(other.bytes.begin(), other.bytes.end());
+		arrays.insert(other.arrays.begin(), other.arrays.end());
+	}
+};
+
 Trace::Trace(Solver &_solver)
     : solver(_solver), cm(cs), assume_cm(assume_cs)
 {
@@ -22,10 +81,16 @@ Trace::Trace(Solver &_solver)
 }
 
 Trace::~Trace(void)
+{
+	freeTree(pathCondsRoot);
+}
+
+void
+Trace::freeTree(Node *root)
 {
 	std::queue<Node *> nodes;
 
-	nodes.push(pathCondsRoot);
+	nodes.push(root);
 	while (!nodes.empty()) {
 		Node *node = nodes.front();
 		nodes.pop();
@@ -39,11 +104,25 @@ Trace::~Trace(void)
 	}
 }
 
+void
+Trace::seed(unsigned int seed)
+{
+	rng.seed(seed);
+}
+
 void
 Trace::reset(void)
 {
 	cs = klee::ConstraintSet();
+	pending.clear();
 	pathCondsCurrent = nullptr;
+
+	deferred.clear();
+	if (dryRun)
+		return; /* retain current path of the last committed run */
+
+	currentNodes.clear();
+	currentPath.clear();
 }
 
 bool
@@ -64,6 +143,9 @@ Trace::addBranch(std::shared_ptr<Trace::Branch> branch, bool condition)
 		ret = true;
 	}
 
+	currentNodes.push_back(node);
+	currentPath.push_back(std::make_pair(node->value, condition));
+
 	if (condition) {
 		if (!node->true_branch)
 			node->true_branch = new Node;
@@ -81,10 +163,31 @@ void
 Trace::add(bool condition, std::shared_ptr<BitVector> bv, uint32_t pc, unsigned pktSeqLen)
 {
 	auto c = (condition) ? bv->eqTrue() : bv->eqFalse();
-	cm.addConstraint(c->expr);
+	pending.push_back(c->expr);
 
 	auto br = std::make_shared<Branch>(Branch(bv, false, pc, pktSeqLen));
-	addBranch(br, condition);
+	if (dryRun)
+		deferred.push_back(std::make_pair(br, condition));
+	else
+		addBranch(br, condition);
+}
+
+void
+Trace::setDryRun(bool enabled)
+{
+	dryRun = enabled;
+}
+
+void
+Trace::commit(void)
+{
+	currentNodes.clear();
+	currentPath.clear();
+
+	assert(pathCondsCurrent == nullptr);
+	for (auto &elem : deferred)
+		addBranch(elem.first, elem.second);
+	deferred.clear();
 }
 
 void
@@ -93,9 +196,38 @@ Trace::assume(std::shared_ptr<BitVector> constraint)
 	assume_cm.addConstraint(constraint->expr);
 }
 
+bool
+Trace::satisfiesAssume(const ConcreteStore &store)
+{
+	std::vector<const klee::Array *> objects;
+	std::vector<std::vector<unsigned char>> values;
+	for (SymbolID id = 0; id < store.limit(); id++) {
+		if (!store.has(id) || !solver.symbols.getArray(id))
+			continue;
+
+		objects.push_back(solver.symbols.getArray(id));
+		values.push_back(intToVector(store.get(id)));
+	}
+
+	// Constraints on variables without a value in the store do not
+	// evaluate to a constant, only constant false results are rejected.
+	klee::Assignment assign(objects, values, true);
+	for (auto c : assume_cs) {
+		auto result = assign.evaluate(c);
+		if (result->isFalse())
+			return false;
+	}
+
+	return true;
+}
+
 klee::Query
 Trace::getQuery(std::shared_ptr<BitVector> bv)
 {
+	for (auto c : pending)
+		cm.addConstraint(c);
+	pending.clear();
+
 	auto expr = cm.simplifyExpr(cs, bv->expr);
 	return klee::Query(cs, expr);
 }
@@ -103,6 +235,8 @@ Trace::getQuery(std::shared_ptr<BitVector> bv)
 klee::Query
 Trace::newQuery(klee::ConstraintSet &cs, Path &path)
 {
+	klee::TimerStatIncrementer timer(stats::queryBuildTime);
+
 	size_t query_idx = path.size() - 1;
 	auto cm = klee::ConstraintManager(cs);
 
@@ -132,8 +266,30 @@ Trace::newQuery(klee::ConstraintSet &cs, Path &path)
 	throw "unreachable";
 }
 
+bool
+Trace::currentUnnegated(unsigned k, Path &path)
+{
+	std::vector<size_t> candidates;
+	for (size_t i = 0; i < currentNodes.size(); i++) {
+		Node *node = currentNodes.at(i);
+		auto branch = node->value;
+
+		if (branch->pktSeqLen >= k && !branch->wasNegated && (!node->true_branch || !node->false_branch))
+			candidates.push_back(i);
+	}
+
+	if (candidates.empty())
+		return false;
+
+	// The last element of the path is the discovered branch, which
+	// is negated by newQuery (see Node::randomUnnegated).
+	size_t idx = candidates.at(rng.getInt32() % candidates.size());
+	path.assign(currentPath.begin(), currentPath.begin() + idx + 1);
+	return true;
+}
+
 std::optional<klee::Assignment>
-Trace::findNewPath(unsigned k)
+Trace::findNewPath(unsigned k, bool preferCurrent)
 {
 	std::optional<klee::Assignment> assign;
 
@@ -141,18 +297,96 @@ Trace::findNewPath(unsigned k)
 		klee::ConstraintSet cs;
 
 		Path path;
-		if (!pathCondsRoot->randomUnnegated(k, path))
+		if (preferCurrent && currentUnnegated(k, path)) {
+			/* found unnegated branch on current path */
+		} else if (!pathCondsRoot->randomUnnegated(k, path, rng)) {
 			return std::nullopt; /* all branches exhausted */
+		}
 
 		auto query = newQuery(cs, path);
+		auto addr = path.back().first->addr;
+		if (isConflicting(addr, query)) {
+			++stats::conflictsPruned;
+			continue;
+		}
+
 		/* std::cout << "Attempting to negate new query at: 0x" << std::hex << path.back().first->addr << std::dec << std::endl; */
-		assign = solver.getAssignment(query);
+		bool unsat = false;
+		assign = solver.getAssignment(query, &unsat);
+		if (unsat)
+			learnConflict(addr, query);
 	} while (!assign.has_value()); /* loop until we found a sat assignment */
 
 	assert(assign.has_value());
 	return assign;
 }
 
+void
+Trace::learnConflict(uint32_t addr, const klee::Query &query)
+{
+	// Constraints (transitively) sharing symbolic bytes with the negated
+	// branch condition, as in klee's IndependentSolver. If the remaining
+	// constraints are satisfiable, this slice is unsat by itself.
+	Footprint footprint(query.expr);
+
+	std::vector<std::pair<klee::ref<klee::Expr>, Footprint>> pending;
+	for (auto c : query.constraints)
+		pending.push_back(std::make_pair(c, Footprint(c)));
+
+	Conflict conflict;
+	for (bool changed = true; changed;) {
+		changed = false;
+		for (auto it = pending.begin(); it != pending.end();) {
+			if (!footprint.intersects(it->second)) {
+				it++;
+				continue;
+			}
+
+			footprint.merge(it->second);
+			conflict.push_back(it->first);
+			it = pending.erase(it);
+			changed = true;
+		}
+	}
+
+	// Assumed constraints may not hold for the executed path, e.g. if
+	// the path was stopped by an assume, hence the remaining constraints
+	// are not necessarily satisfiable. Confirm that the slice is unsat.
+	if (!pending.empty()) {
+		bool unsat = false;
+		solver.getAssignment(klee::Query(klee::ConstraintSet(conflict), query.expr), &unsat);
+		if (!unsat)
+			return;
+	}
+	conflict.push_back(query.expr);
+
+	auto &learned = conflicts[addr];
+	if (learned.size() >= MAX_CONFLICTS)
+		learned.erase(learned.begin());
+	learned.push_back(conflict);
+	++stats::conflictsLearned;
+}
+
+bool
+Trace::isConflicting(uint32_t addr, const klee::Query &query)
+{
+	auto it = conflicts.find(addr);
+	if (it == conflicts.end())
+		return false;
+
+	klee::ExprHashSet constraints(query.constraints.begin(), query.constraints.end());
+	for (auto &conflict : it->second) {
+		if (conflict.back() != query.expr)
+			continue;
+
+		auto end = conflict.end() - 1;
+		if (std::all_of(conflict.begin(), end, [&](const klee::ref<klee::Expr> &c) { return constraints.count(c); }))
+			return true;
+	}
+
+	return false;
+}
+
 std::optional<klee::Assignment>
 Trace::fromAssume(void)
 {
@@ -168,9 +402,107 @@ Trace::getStore(const klee::Assignment &assign)
 		auto array = b.first;
 		auto value = b.second;
 
-		std::string name = array->getName();
-		store[name] = intFromVector(value);
+		auto id = solver.symbols.lookup(array);
+		if (!id.has_value())
+			id = solver.symbols.intern(array->getName());
+		store.set(*id, intFromVector(value));
 	}
 
 	return store;
 }
+
+/* Flags describing a serialized Node */
+enum {
+	NODE_HAS_VALUE = 1 << 0,
+	NODE_HAS_TRUE = 1 << 1,
+	NODE_HAS_FALSE = 1 << 2,
+};
+
+void
+Trace::save(Serializer &out)
+{
+	out.write((uint64_t)std::distance(assume_cs.begin(), assume_cs.end()));
+	for (auto c : assume_cs)
+		out.write(c);
+
+	// Nodes are written in pre-order, traverse the tree
+	// iteratively to avoid stack overflows (see ~Trace).
+	std::vector<Node *> nodes;
+	nodes.push_back(pathCondsRoot);
+	while (!nodes.empty()) {
+		Node *node = nodes.back();
+		nodes.pop_back();
+
+		uint64_t flags = 0;
+		if (node->value)
+			flags |= NODE_HAS_VALUE;
+		if (node->true_branch)
+			flags |= NODE_HAS_TRUE;
+		if (node->false_branch)
+			flags |= NODE_HAS_FALSE;
+
+		out.write(flags);
+		if (node->value) {
+			auto branch = node->value;
+			out.write(branch->bv->expr);
+			out.write((uint64_t)branch->wasNegated);
+			out.write((uint64_t)branch->addr);
+			out.write((uint64_t)branch->pktSeqLen);
+		}
+
+		if (node->false_branch)
+			nodes.push_back(node->false_branch);
+		if (node->true_branch)
+			nodes.push_back(node->true_branch);
+	}
+}
+
+void
+Trace::load(Deserializer &in)
+{
+	klee::ConstraintSet constraints;
+	klee::ConstraintManager manager(constraints);
+
+	auto nassume = in.readInt();
+	for (uint64_t i = 0; i < nassume; i++)
+		manager.addConstraint(in.readExpr());
+
+	// Reconstruct tree in pre-order (see Trace::save), each stack
+	// entry refers to a child pointer which still needs to be read.
+	Node *root = nullptr;
+	std::vector<Node **> pending;
+	pending.push_back(&root);
+	try {
+		while (!pending.empty()) {
+			Node **ptr = pending.back();
+			pending.pop_back();
+
+			Node *node = new Node;
+			*ptr = node;
+
+			auto flags = in.readInt();
+			if (flags & NODE_HAS_VALUE) {
+				auto bv = std::make_shared<BitVector>(BitVector(in.readExpr()));
+				bool wasNegated = in.readInt();
+				auto addr = (uint32_t)in.readInt();
+				auto pktSeqLen = (unsigned)in.readInt();
+
+				node->value = std::make_shared<Branch>(Branch(bv, wasNegated, addr, pktSeqLen));
+			}
+
+			if (flags & NODE_HAS_FALSE)
+				pending.push_back(&node->false_branch);
+			if (flags & NODE_HAS_TRUE)
+				pending.push_back(&node->true_branch);
+		}
+	} catch (...) {
+		freeTree(root);
+		throw;
+	}
+
+	freeTree(pathCondsRoot);
+	pathCondsRoot = root;
+
+	assume_cs = constraints;
+	reset();
+}
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2022 Group of Computer Architecture, University of Bremen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Minimal stand-in for the state protocol server (SPS). Instead of
+// deriving input formats from a protocol specification, a fixed list of
+// responses is served: The n-th message after a reset is answered with
+// the n-th response, the last response is repeated once the list is
+// exhausted. This allows running hifive-vp without an SPS installation,
+// e.g. for benchmarking.
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <ctype.h>
+#include <err.h>
+#include <errno.h>
+#include <netdb.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+
+#include "bencode.hpp"
+
+// Message types, see ProtocolStates.
+enum {
+	SPS_DATA = 0x0,
+	SPS_RST = 0x1,
+};
+
+// Two unconstrained fields: An 8-bit message type and a 32-bit payload.
+static const char *default_response = "ll4:typei8elee"
+                                      "l7:payloadi32elee"
+                                      "e";
+
+static std::vector<std::string> responses;
+
+static void
+load_responses(const char *path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		err(EXIT_FAILURE, "open failed for '%s'", path);
+
+	std::string content((std::istreambuf_iterator<char>(file)),
+	                    std::istreambuf_iterator<char>());
+
+	// The file consists of multiple bencode lists, one per response.
+	auto begin = content.cbegin();
+	while (begin != content.cend()) {
+		if (isspace(*begin)) {
+			begin++;
+			continue;
+		}
+
+		auto start = begin;
+		try {
+			auto data = bencode::decode(begin, content.cend());
+			if (!std::get_if<bencode::list>(&data))
+				throw std::invalid_argument("expected list");
+		} catch (const std::invalid_argument &e) {
+			errx(EXIT_FAILURE, "invalid response in '%s': %s", path, e.what());
+		}
+		responses.push_back(std::string(start, begin));
+	}
+
+	if (responses.empty())
+		errx(EXIT_FAILURE, "no responses in '%s'", path);
+}
+
+static bool
+read_integer(FILE *stream, long long *value)
+{
+	if (fgetc(stream) != 'i')
+		return false;
+	return fscanf(stream, "%lld", value) == 1 && fgetc(stream) == 'e';
+}
+
+// Reads a single bencode::list{type, value} request. For SPS_DATA the
+// value is a string containing the message, for SPS_RST an integer.
+static bool
+read_request(FILE *stream, long long *type)
+{
+	if (fgetc(stream) != 'l' || !read_integer(stream, type))
+		return false;
+
+	int c = fgetc(stream);
+	if (c == EOF) {
+		return false;
+	} else if (c == 'i') {
+		long long value;
+		ungetc(c, stream);
+		if (!read_integer(stream, &value))
+			return false;
+	} else {
+		size_t len;
+		ungetc(c, stream);
+		if (fscanf(stream, "%zu", &len) != 1 || fgetc(stream) != ':')
+			return false;
+		for (size_t i = 0; i < len; i++) {
+			if (fgetc(stream) == EOF)
+				return false;
+		}
+	}
+
+	return fgetc(stream) == 'e';
+}
+
+static bool
+write_response(int fd, const std::string &response)
+{
+	size_t written = 0;
+	while (written < response.size()) {
+		ssize_t r = write(fd, response.data() + written, response.size() - written);
+		if (r == -1) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		written += r;
+	}
+
+	return true;
+}
+
+static void
+serve(int fd)
+{
+	FILE *stream = fdopen(fd, "r");
+	if (!stream)
+		err(EXIT_FAILURE, "fdopen failed");
+
+	size_t state = 0;
+	long long type;
+	while (read_request(stream, &type)) {
+		switch (type) {
+		case SPS_RST:
+			state = 0;
+			break;
+		case SPS_DATA:
+			if (!write_response(fd, responses.at(std::min(state, responses.size() - 1))))
+				goto out;
+			state++;
+			break;
+		default:
+			warnx("unknown request type %lld", type);
+			goto out;
+		}
+	}
+
+out:
+	fclose(stream);
+}
+
+static int
+listen_unix(const char *path)
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	memset(&addr, '\0', sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr.sun_path))
+		errx(EXIT_FAILURE, "unix socket path too long: %s", path);
+	strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+	if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+		err(EXIT_FAILURE, "socket failed");
+
+	unlink(path);
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1)
+		err(EXIT_FAILURE, "bind failed for '%s'", path);
+
+	return fd;
+}
+
+static int
+listen_inet(const char *host, const char *service)
+{
+	struct addrinfo hint, *res;
+	int fd, ret, reuse = 1;
+
+	memset(&hint, '\0', sizeof(hint));
+	hint.ai_family = AF_UNSPEC;
+	hint.ai_socktype = SOCK_STREAM;
+	hint.ai_flags = AI_PASSIVE;
+
+	if ((ret = getaddrinfo(host, service, &hint, &res)))
+		errx(EXIT_FAILURE, "getaddrinfo failed: %s", gai_strerror(ret));
+
+	if ((fd = socket(res->ai_family, SOCK_STREAM, 0)) == -1)
+		err(EXIT_FAILURE, "socket failed");
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+	if (bind(fd, res->ai_addr, res->ai_addrlen) == -1)
+		err(EXIT_FAILURE, "bind failed");
+
+	freeaddrinfo(res);
+	return fd;
+}
+
+static void
+usage(const char *progname)
+{
+	std::cerr << "USAGE: " << progname << " [-h HOST] [-p PORT] [-r RESPONSES]" << std::endl
+	          << "       " << progname << " -u PATH [-r RESPONSES]" << std::endl;
+	exit(EXIT_FAILURE);
+}
+
+int
+main(int argc, char **argv)
+{
+	const char *host = "127.0.0.1", *port = "2342", *path = nullptr;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "h:p:u:r:")) != -1) {
+		switch (opt) {
+		case 'h':
+			host = optarg;
+			break;
+		case 'p':
+			port = optarg;
+			break;
+		case 'u':
+			path = optarg;
+			break;
+		case 'r':
+			load_responses(optarg);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	if (optind != argc)
+		usage(argv[0]);
+	if (responses.empty())
+		responses.push_back(default_response);
+
+	int fd = (path) ? listen_unix(path) : listen_inet(host, port);
+	if (listen(fd, SOMAXCONN) == -1)
+		err(EXIT_FAILURE, "listen failed");
+
+	// Each connection is served by a separate process, e.g. for
+	// parallel replay of test cases (see SYMEX_JOBS).
+	signal(SIGCHLD, SIG_IGN);
+	for (;;) {
+		int conn = accept(fd, NULL, NULL);
+		if (conn == -1) {
+			if (errno == EINTR)
+				continue;
+			err(EXIT_FAILURE, "accept failed");
+		}
+
+		switch (fork()) {
+		case -1:
+			err(EXIT_FAILURE, "fork failed");
+		case 0:
+			close(fd);
+			serve(conn);
+			_exit(EXIT_SUCCESS);
+		default:
+			close(conn);
+			break;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
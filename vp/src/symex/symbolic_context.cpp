@@ -40,6 +40,17 @@ SymbolicContext::SymbolicContext(void)
 	}
 }
 
+void
+SymbolicContext::seed(unsigned int seed)
+{
+	klee::RNG seeds(seed);
+
+	rng.seed(seeds.getInt32());
+	trace.seed(seeds.getInt32());
+	ctx.seed(seeds.getInt32());
+	mutator.seed(seeds.getInt32());
+}
+
 void
 SymbolicContext::assume(std::shared_ptr<clover::BitVector> constraint)
 {
@@ -62,7 +73,7 @@ SymbolicContext::assume(std::shared_ptr<clover::BitVector> constraint)
 }
 
 bool
-SymbolicContext::setupNewValues(void)
+SymbolicContext::setupNewValues(bool novel)
 {
 	if (enforcing_assume) {
 		enforcing_assume = false;
@@ -73,7 +84,7 @@ SymbolicContext::setupNewValues(void)
 		return true;
 	}
 
-	return ctx.setupNewValues(symbolic_context.current_length(), trace);
+	return ctx.setupNewValues(symbolic_context.current_length(), trace, novel);
 }
 
 void
@@ -107,7 +118,30 @@ SymbolicContext::early_exit(unsigned k)
 	auto store = ctx.getPrevStore();
 	// XXX: Store can be empty if packet didn't contain symbolic fields.
 	//assert(!store.empty() && "early_exit ConcreteStore was empty");
-	partially_explored[k].push_back(store);
+	if (dry_run)
+		deferred_partial = std::make_pair(k, store);
+	else
+		partially_explored[k].push_back(store);
+}
+
+void
+SymbolicContext::set_dry_run(bool enabled)
+{
+	// The path is committed after the dry-run mode was disabled.
+	if (enabled)
+		deferred_partial = std::nullopt;
+
+	dry_run = enabled;
+	trace.setDryRun(enabled);
+}
+
+void
+SymbolicContext::commit(void)
+{
+	if (deferred_partial.has_value())
+		partially_explored[deferred_partial->first].push_back(deferred_partial->second);
+	deferred_partial = std::nullopt;
+	trace.commit();
 }
 
 void
@@ -125,9 +159,50 @@ SymbolicContext::random_partial(unsigned k)
 		return std::nullopt;
 
 	assert(!partially_explored[k].empty());
-	idx = rand() % partially_explored[k].size();
+	idx = rng.getInt32() % partially_explored[k].size();
 
 	clover::ConcreteStore store = partially_explored[k].at(idx);
 	partially_explored[k].erase(partially_explored[k].begin() + idx);
 	return store;
 }
+
+void
+SymbolicContext::save(clover::Serializer &out)
+{
+	out.write((uint64_t)enforcing_assume);
+	out.write((uint64_t)constraints.size());
+	for (auto &c : constraints)
+		out.write(c.first);
+
+	out.write((uint64_t)partially_explored.size());
+	for (auto &p : partially_explored) {
+		out.write((uint64_t)p.first);
+		out.write((uint64_t)p.second.size());
+		for (auto &store : p.second)
+			out.write(store);
+	}
+
+	trace.save(out);
+}
+
+void
+SymbolicContext::load(clover::Deserializer &in)
+{
+	enforcing_assume = in.readInt();
+
+	constraints.clear();
+	auto nconstraints = in.readInt();
+	for (uint64_t i = 0; i < nconstraints; i++)
+		constraints[in.readExpr()] = true;
+
+	partially_explored.clear();
+	auto npartial = in.readInt();
+	for (uint64_t i = 0; i < npartial; i++) {
+		auto k = (unsigned)in.readInt();
+		auto nstores = in.readInt();
+		for (uint64_t j = 0; j < nstores; j++)
+			partially_explored[k].push_back(in.readStore());
+	}
+
+	trace.load(in);
+}
@@ -35,16 +35,28 @@ private:
 	bool enforcing_assume = false;
 
 	std::map<unsigned, std::vector<clover::ConcreteStore>> partially_explored;
+	klee::RNG rng;
+
+	bool dry_run = false;
+	std::optional<std::pair<unsigned, clover::ConcreteStore>> deferred_partial;
 
 public:
 	clover::Solver solver;
 	clover::Trace trace;
 	clover::ExecutionContext ctx;
+	clover::Mutator mutator;
 
 	SymbolicContext(void);
 
+	// Seed the random number generators of all components. Each
+	// component uses its own generator, seeded from the given seed.
+	void seed(unsigned int seed);
+
 	void assume(std::shared_ptr<clover::BitVector> constraint);
-	bool setupNewValues(void);
+
+	// Setup values for the next path. If novel is true, the last path
+	// reached new coverage and branches along it are negated first.
+	bool setupNewValues(bool novel = false);
 
 	// Prepare execution of the software with a packet sequence
 	// of the specified length. That is, expect the software to
@@ -69,6 +81,17 @@ public:
 	void early_exit(unsigned k);
 	std::optional<clover::ConcreteStore> random_partial(unsigned k);
 	void clear_partial(void);
+
+	// In dry-run mode, the current path is neither added to the
+	// execution tree nor recorded as partially explored, unless it
+	// is committed after execution (see Trace::setDryRun).
+	void set_dry_run(bool enabled);
+	void commit(void);
+
+	// Save or restore assumed constraints, partially explored
+	// packet sequences and the execution tree (see symbolic_explore).
+	void save(clover::Serializer &out);
+	void load(clover::Deserializer &in);
 };
 
 extern SymbolicContext symbolic_context;
@@ -59,7 +59,7 @@ SymbolicCTRL::write_ctrl(RegisterRange::WriteInfo t)
 
 	uint32_t *val = &symbolic_ctrl[0];
 	if (*val & CTRL_ERROR) {
-		SC_REPORT_ERROR("/AGRA/riscv-vp/host-error", "SYS_host_error");
+		symbolic_exploration::report_error(symif.error_signature());
 		symif.sys_exit();
 	}
 
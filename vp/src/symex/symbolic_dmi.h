@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2020,2021 Group of Computer Architecture, University of Bremen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RISCV_ISA_SYMBOLIC_DMI_H
+#define RISCV_ISA_SYMBOLIC_DMI_H
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "core/common/dmi.h"
+
+// Direct memory interface for a SymbolicMemory. In addition to the
+// concrete byte page, a pointer to a shadow bitmap is provided which
+// contains one bit per byte. If the bit is set, the corresponding byte
+// holds a symbolic value and must be accessed through TLM to retrieve
+// the symbolic part. Clean bytes can be accessed directly.
+class SymbolicMemoryDMI {
+	MemoryDMI dmi;
+	uint64_t *shadow;
+
+	SymbolicMemoryDMI(MemoryDMI dmi, uint64_t *shadow) : dmi(dmi), shadow(shadow) {}
+
+	inline bool is_symbolic(uint64_t off) {
+		return shadow[off / 64] & ((uint64_t)1 << (off % 64));
+	}
+
+public:
+	static SymbolicMemoryDMI create_start_size_mapping(uint8_t *mem, uint64_t *shadow, uint64_t start, uint64_t size) {
+		return SymbolicMemoryDMI(MemoryDMI::create_start_size_mapping(mem, start, size), shadow);
+	}
+
+	MemoryDMI &get_concrete_dmi() {
+		return dmi;
+	}
+
+	bool contains(uint64_t addr, size_t n) {
+		return dmi.contains(addr) && dmi.contains(addr + n - 1);
+	}
+
+	bool is_concrete(uint64_t addr, size_t n) {
+		assert(contains(addr, n));
+
+		uint64_t off = addr - dmi.get_start();
+		for (size_t i = 0; i < n; i++) {
+			if (is_symbolic(off + i))
+				return false;
+		}
+
+		return true;
+	}
+
+	void load(uint64_t addr, uint8_t *buf, size_t n) {
+		assert(contains(addr, n));
+		memcpy(buf, dmi.get_raw_mem_ptr() + (addr - dmi.get_start()), n);
+	}
+
+	// Stores a concrete value, this discards any symbolic value
+	// previously stored at the given address range.
+	void store(uint64_t addr, const uint8_t *buf, size_t n) {
+		assert(contains(addr, n));
+
+		uint64_t off = addr - dmi.get_start();
+		memcpy(dmi.get_raw_mem_ptr() + off, buf, n);
+		for (size_t i = 0; i < n; i++)
+			shadow[(off + i) / 64] &= ~((uint64_t)1 << ((off + i) % 64));
+	}
+};
+
+#endif
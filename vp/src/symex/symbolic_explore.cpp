@@ -25,6 +25,8 @@
 #include <string.h>
 #include <unistd.h>
 #include <signal.h>
+#include <glob.h>
+#include <sys/wait.h>
 
 /* Debug leaks with valgrind --leak-check=full --undef-value-errors=no
  * Also: Define valgrind here to prevent spurious Z3 memory leaks. */
@@ -32,7 +34,10 @@
 #include <z3.h>
 #endif
 
+#include <algorithm>
+#include <iomanip>
 #include <iostream>
+#include <map>
 #include <systemc>
 #include <filesystem>
 #include <systemc>
@@ -40,6 +45,7 @@
 #include <clover/clover.h>
 #include "symbolic_explore.h"
 #include "symbolic_context.h"
+#include "symbolic_stats.h"
 
 #include "rawmode.h"
 
@@ -47,41 +53,198 @@
 #define TIMEBUDGET_ENV "SYMEX_TIMEBUDGET"
 #define ERR_EXIT_ENV "SYMEX_ERREXIT"
 #define MAXPKTSEQ_ENV "SYMEX_MAXPKTSEQ"
+#define CHECKPOINT_ENV "SYMEX_CHECKPOINT"
+#define CHECKPOINT_INTERVAL_ENV "SYMEX_CHECKPOINT_INTERVAL"
+#define RESUME_ENV "SYMEX_RESUME"
+#define JOBS_ENV "SYMEX_JOBS"
+#define STATS_ENV "SYMEX_STATS"
+#define STATS_INTERVAL_ENV "SYMEX_STATS_INTERVAL"
+#define SEED_ENV "SYMEX_SEED"
+#define MAXINSTR_ENV "SYMEX_MAXINSTR"
+#define MAXSIMTIME_ENV "SYMEX_MAXSIMTIME"
+#define MAXWALLTIME_ENV "SYMEX_MAXWALLTIME"
+#define MAXLOOP_ENV "SYMEX_MAXLOOP"
+#define ERRBUCKET_ENV "SYMEX_ERRBUCKET"
+#define MUTATIONS_ENV "SYMEX_MUTATIONS"
+
+// Default interval between checkpoints in seconds.
+#define CHECKPOINT_INTERVAL 300
+#define CHECKPOINT_VERSION 4
+
+// Default number of test cases written per error signature.
+#define ERRBUCKET_SIZE 1
 
 static std::filesystem::path *testcase_path = nullptr;
 static size_t errors_found = 0;
+static size_t errors_stored = 0;
+static size_t hangs_found = 0;
 static size_t paths_found = 0;
 
+static const char* error_mtype = "/AGRA/riscv-vp/host-error";
 static const char* assume_mtype = "/AGRA/riscv-vp/assume-notification";
 static bool stopped = false;
 
+// Whether the current path exceeded its budget (see stop_hang).
+static const char* hang_mtype = "/AGRA/riscv-vp/hang-notification";
+static bool hung = false;
+
+symbolic_exploration::PathBudget symbolic_exploration::path_budget;
+
+// Errors with the same signature share a bucket, only the first
+// test cases of each bucket are written (see SYMEX_ERRBUCKET).
+struct ErrorBucket {
+	size_t errors = 0;
+	std::vector<std::string> testcases;
+};
+
+static std::map<symbolic_exploration::ErrorSignature, ErrorBucket> error_buckets;
+static symbolic_exploration::ErrorSignature current_error;
+static unsigned long bucket_size = ERRBUCKET_SIZE;
+
+// Exit after errors of the given number of buckets were found.
+static unsigned long errexit = 0;
+
 static unsigned maxpktseq = 0;
 static unsigned pktseqlen = 0;
 
-static std::chrono::duration<double, std::milli> solver_time;
+// Seed for all random number generators (see SymbolicContext::seed).
+static unsigned int seed = 0;
+
+// Novelty of the last explored path (see Coverage::path_novelty).
+static size_t last_novelty = 0;
+
+// Number of mutations executed after each solver-derived path.
+static unsigned long mutations = 0;
 
 extern void dump_coverage(void);
 extern double dump_instr_coverage(void);
 extern size_t executed_branches(void);
+extern size_t path_novelty(void);
+extern std::string checkpoint_coverage(void);
+extern void restore_coverage(const std::string &);
+extern void merge_coverage(const std::string &);
+extern void dump_profile(void);
+extern bool dump_trace(const std::string &);
+
+static const char checkpoint_magic[] = "SYMEXCKP";
+static const char *checkpoint_path = nullptr;
+static std::chrono::seconds checkpoint_interval(CHECKPOINT_INTERVAL);
+static std::chrono::steady_clock::time_point last_checkpoint;
+
+// Whether the exploration state was restored from a checkpoint.
+static bool resumed = false;
+
+// JSON lines file for periodic statistics (see write_stats).
+static std::ofstream stats_file;
+static unsigned long stats_interval = 1;
+static unsigned long stats_pending = 0;
+static std::chrono::steady_clock::time_point start_time;
+
+static size_t
+unique_errors(void)
+{
+	return std::count_if(error_buckets.begin(), error_buckets.end(), [](auto &bucket) {
+		return !bucket.second.testcases.empty();
+	});
+}
+
+// Summary of all buckets with at least one test case, as JSON lines.
+static void
+write_error_index(void)
+{
+	if (!errors_stored)
+		return;
+
+	auto path = *testcase_path / "errors.jsonl";
+	std::ofstream file(path, std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+		throw std::runtime_error("failed to open " + path.string());
+
+	for (auto &entry : error_buckets) {
+		auto &sig = entry.first;
+		auto &bucket = entry.second;
+		if (bucket.testcases.empty())
+			continue;
+
+		file << "{\"pc\":\"0x" << std::hex << sig.pc << "\",\"cause\":";
+		if (sig.cause == symbolic_exploration::ErrorSignature::NO_TRAP)
+			file << "null";
+		else
+			file << "\"0x" << sig.cause << "\"";
+		file << ",\"stack\":\"" << std::setw(16) << std::setfill('0') << sig.stack << "\""
+		     << std::dec << ",\"errors\":" << bucket.errors << ",\"testcases\":[";
+		for (size_t i = 0; i < bucket.testcases.size(); i++)
+			file << ((i) ? "," : "") << "\"" << bucket.testcases[i] << "\"";
+		file << "]}" << std::endl;
+	}
+}
+
+static void
+write_stats(void)
+{
+	if (!stats_file.is_open())
+		return;
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+	stats_file << "{\"time\":" << elapsed.count()
+		<< ",\"paths\":" << paths_found
+		<< ",\"errors\":" << errors_found
+		<< ",\"unique_errors\":" << unique_errors()
+		<< ",\"hangs\":" << hangs_found
+		<< ",\"pktseq\":" << pktseqlen
+		<< ",\"novelty\":" << last_novelty
+		<< ",\"branches\":" << executed_branches()
+		<< ",\"instr_coverage\":" << dump_instr_coverage()
+		<< ",\"stats\":";
+	symbolic_stats.dump_json(stats_file);
+	stats_file << "}" << std::endl;
+}
+
+static void
+setup_stats(void)
+{
+	start_time = std::chrono::steady_clock::now();
+
+	char *path = getenv(STATS_ENV);
+	if (!path)
+		return;
 
-std::fstream coverage_file("/tmp/coverage.txt", std::ios::out|std::ios::trunc);
+	stats_file.open(path, std::ios::out | std::ios::trunc);
+	if (!stats_file.is_open())
+		throw std::runtime_error("failed to open " + std::string(path));
+
+	char *interval = getenv(STATS_INTERVAL_ENV);
+	if (interval) {
+		errno = 0;
+		stats_interval = strtoul(interval, NULL, 10);
+		if (!stats_interval && errno)
+			throw std::system_error(errno, std::generic_category(), interval);
+	}
+}
 
 static void
 dump_stats(void)
 {
-	auto stime = std::chrono::duration_cast<std::chrono::seconds>(solver_time);
+	auto stime = std::chrono::duration_cast<std::chrono::seconds>(symbolic_stats.elapsed(SymbolicStats::PATH_SEARCH));
 
 	std::cout << std::endl << "---" << std::endl;
 	std::cout << "Unique paths found: " << paths_found << std::endl;
 	std::cout << "Solver Time: " << stime.count() << " seconds" << std::endl;
 	std::cout << "Packet Sequence: " << pktseqlen << " / " << maxpktseq << std::endl;
+	std::cout << "Seed: " << seed << std::endl;
+	symbolic_stats.dump(std::cout);
 	dump_coverage();
-	if (errors_found > 0) {
-		std::cout << "Errors found: " << errors_found << std::endl;
+	dump_profile();
+	if (errors_found > 0)
+		std::cout << "Errors found: " << errors_found << " (" << unique_errors() << " unique)" << std::endl;
+	if (hangs_found > 0)
+		std::cout << "Hangs found: " << hangs_found << std::endl;
+	if (errors_stored > 0 || hangs_found > 0)
 		std::cout << "Testcase directory: " << *testcase_path << std::endl;
-	}
 
-	coverage_file.close();
+	write_error_index();
+	write_stats();
+	stats_file.close();
 }
 
 static std::optional<std::string>
@@ -99,35 +262,100 @@ dump_input(std::string fn)
 	if (!file.is_open())
 		throw std::runtime_error("failed to open " + path.string());
 
-	clover::TestCase::toFile(store, file);
+	clover::TestCase::toFile(symbolic_context.solver.symbols, store, file);
 	return path;
 }
 
+void
+symbolic_exploration::report_error(const ErrorSignature &signature)
+{
+	current_error = signature;
+	SC_REPORT_ERROR(error_mtype, "SYS_host_error");
+}
+
 void
 symbolic_exploration::stop_assume(void)
 {
 	SC_REPORT_ERROR(assume_mtype, "AssumeNotification");
 }
 
+void
+symbolic_exploration::stop_hang(const std::string &reason)
+{
+	SC_REPORT_ERROR(hang_mtype, reason.c_str());
+}
+
+// Returns false if the error does not depend on symbolic input.
+static bool
+record_error(void)
+{
+	auto &bucket = error_buckets[current_error];
+	bucket.errors++;
+	errors_found++;
+
+	if (bucket_size && bucket.testcases.size() >= bucket_size) {
+		std::cerr << "Found known error (" << bucket.errors << " occurrences), see "
+			<< bucket.testcases.front() << "." << std::endl;
+		return true;
+	}
+
+	auto name = "error" + std::to_string(errors_stored + 1);
+	auto path = dump_input(name);
+	if (!path.has_value())
+		return false;
+
+	errors_stored++;
+	bucket.testcases.push_back(name);
+	write_error_index();
+
+	std::cerr << "Found error, use " << *path << " to reproduce." << std::endl;
+	if (dump_trace(*path + ".trace"))
+		std::cerr << "Instruction trace written to " << *path << ".trace" << std::endl;
+
+	if (errexit && bucket.testcases.size() == 1 && unique_errors() >= errexit) {
+		std::cerr << "Exit on error set, terminating..." << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	return true;
+}
+
+static void
+record_hang(const sc_core::sc_report& report)
+{
+	std::cerr << "Path terminated: " << report.get_msg() << std::endl;
+
+	auto path = dump_input("hang" + std::to_string(hangs_found + 1));
+	if (!path.has_value())
+		return;
+
+	hangs_found++;
+	std::cerr << "Found hang, use " << *path << " to reproduce." << std::endl;
+	if (dump_trace(*path + ".trace"))
+		std::cerr << "Instruction trace written to " << *path << ".trace" << std::endl;
+}
+
 static void
 report_handler(const sc_core::sc_report& report, const sc_core::sc_actions& actions)
 {
 	auto nactions = actions;
 	auto mtype = report.get_msg_type();
 
-	if (!strcmp(mtype, "/AGRA/riscv-vp/host-error") || !testcase_path) {
-		auto path = dump_input("error" + std::to_string(++errors_found));
-		if (!path.has_value())
+	if (!strcmp(mtype, error_mtype) || !testcase_path) {
+		if (!record_error())
 			return;
 
-		std::cerr << "Found error, use " << *path << " to reproduce." << std::endl;
-		if (getenv(ERR_EXIT_ENV)) {
-			std::cerr << "Exit on first error set, terminating..." << std::endl;
-			exit(EXIT_FAILURE);
-		}
-
 		nactions &= ~sc_core::SC_DISPLAY; // Prevent SystemC output
 		nactions &= sc_core::SC_STOP;     // Stop SystemC simulation
+	} else if (!strcmp(mtype, hang_mtype)) {
+		// The handler is invoked again for the report caught by
+		// sc_elab_and_sim, only record the hang once.
+		if (!hung)
+			record_hang(report);
+		hung = true;
+
+		// Keep SC_THROW to leave the simulation immediately.
+		nactions &= ~sc_core::SC_DISPLAY;
 	} else if (!strcmp(mtype, assume_mtype)) {
 		stopped = true;
 
@@ -157,7 +385,7 @@ static void
 remove_testdir(void)
 {
 	assert(testcase_path != nullptr);
-	if (errors_found > 0)
+	if (errors_stored > 0 || hangs_found > 0)
 		return;
 
 	// Remove test directory if no errors were found
@@ -169,14 +397,19 @@ remove_testdir(void)
 }
 
 static void
-create_testdir(void)
+create_testdir(std::optional<std::filesystem::path> reuse = std::nullopt)
 {
 	char *dirpath;
 	char tmpl[] = "/tmp/clover_testsXXXXXX";
 
-	if (!(dirpath = mkdtemp(tmpl)))
-		throw std::system_error(errno, std::generic_category());
-	testcase_path = new std::filesystem::path(dirpath);
+	// Continue to use the test directory of a resumed exploration.
+	if (reuse.has_value() && std::filesystem::is_directory(*reuse)) {
+		testcase_path = new std::filesystem::path(*reuse);
+	} else {
+		if (!(dirpath = mkdtemp(tmpl)))
+			throw std::system_error(errno, std::generic_category());
+		testcase_path = new std::filesystem::path(dirpath);
+	}
 
 	if (std::atexit(remove_testdir))
 		throw std::runtime_error("std::atexit failed");
@@ -185,29 +418,421 @@ create_testdir(void)
 static bool
 setupNewValues(void)
 {
-	auto start = std::chrono::steady_clock::now();
-	auto r = symbolic_context.setupNewValues();
-	auto end = std::chrono::steady_clock::now();
+	SymbolicStats::Timer timer(SymbolicStats::PATH_SEARCH);
+	return symbolic_context.setupNewValues(last_novelty > 0);
+}
 
-	solver_time += end - start;
-	return r;
+static void
+reset_simcontext(void)
+{
+	// Reset SystemC simulation context
+	// See also: https://github.com/accellera-official/systemc/issues/8
+	if (sc_core::sc_curr_simcontext) {
+		sc_core::sc_report_handler::release();
+		delete sc_core::sc_curr_simcontext;
+	}
+	sc_core::sc_curr_simcontext = NULL;
 }
 
 static int
-run_test(const char *path, int argc, char **argv)
+run_test(const std::string &fp, int argc, char **argv)
 {
-	std::string fp(path);
 	std::ifstream file(fp);
 	if (!file.is_open())
 		throw std::runtime_error("failed to open " + fp);
 
 	clover::ExecutionContext &ctx = symbolic_context.ctx;
-	clover::ConcreteStore store = clover::TestCase::fromFile(fp, file);
+	clover::ConcreteStore store = clover::TestCase::fromFile(symbolic_context.solver.symbols, fp, file);
 
+	// Discard values of a previously replayed test case.
+	ctx.clear();
 	ctx.setupNewValues(store);
+
+	symbolic_context.trace.reset();
+	symbolic_context.prepare_packet_sequence(0);
+
+	reset_simcontext();
 	return sc_core::sc_elab_and_sim(argc, argv);
 }
 
+// Exit status of a test case which could not be replayed.
+#define REPLAY_ERROR -1
+
+// Record types written by replay workers and processes forked by the
+// fork server (see replay_worker and fork_test).
+enum {
+	REPLAY_RESULT = 'R',
+	REPLAY_COVERAGE = 'C',
+};
+
+static std::vector<std::string>
+collect_tests(const char *pattern)
+{
+	std::vector<std::string> tests;
+
+	if (std::filesystem::is_directory(pattern)) {
+		// Skip auxiliary files, e.g. instruction traces, which are
+		// stored alongside the test cases but have an extension.
+		for (auto &entry : std::filesystem::directory_iterator(pattern)) {
+			if (entry.is_regular_file() && !entry.path().has_extension())
+				tests.push_back(entry.path().string());
+		}
+	} else {
+		glob_t g;
+		int r = glob(pattern, 0, NULL, &g);
+		if (r && r != GLOB_NOMATCH)
+			throw std::runtime_error("glob failed for " + std::string(pattern));
+
+		for (size_t i = 0; i < g.gl_pathc; i++)
+			tests.push_back(g.gl_pathv[i]);
+		globfree(&g);
+	}
+
+	std::sort(tests.begin(), tests.end());
+	return tests;
+}
+
+static void
+write_all(int fd, const void *buf, size_t len)
+{
+	const char *p = (const char *)buf;
+	while (len > 0) {
+		ssize_t n = write(fd, p, len);
+		if (n == -1 && errno == EINTR)
+			continue;
+		else if (n == -1)
+			throw std::system_error(errno, std::generic_category());
+
+		p += n;
+		len -= n;
+	}
+}
+
+static bool
+read_all(int fd, void *buf, size_t len)
+{
+	char *p = (char *)buf;
+	while (len > 0) {
+		ssize_t n = read(fd, p, len);
+		if (n == -1 && errno == EINTR)
+			continue;
+		else if (n == -1)
+			throw std::system_error(errno, std::generic_category());
+		else if (n == 0)
+			return false;
+
+		p += n;
+		len -= n;
+	}
+
+	return true;
+}
+
+static void
+write_result(int fd, size_t idx, int32_t status)
+{
+	char type = REPLAY_RESULT;
+	uint64_t i = idx;
+
+	write_all(fd, &type, sizeof(type));
+	write_all(fd, &i, sizeof(i));
+	write_all(fd, &status, sizeof(status));
+}
+
+static void
+write_coverage(int fd)
+{
+	std::string coverage = checkpoint_coverage();
+	uint64_t len = coverage.size();
+	char type = REPLAY_COVERAGE;
+
+	write_all(fd, &type, sizeof(type));
+	write_all(fd, &len, sizeof(len));
+	write_all(fd, coverage.data(), len);
+}
+
+// Read the records written by a replay worker or a process forked by
+// the fork server, until the writing process closed the pipe.
+static void
+collect_records(int fd, std::vector<int> &results)
+{
+	char type;
+	while (read_all(fd, &type, 1)) {
+		if (type == REPLAY_RESULT) {
+			uint64_t idx;
+			int32_t status;
+
+			if (!read_all(fd, &idx, sizeof(idx)) || !read_all(fd, &status, sizeof(status)))
+				break;
+			results.at(idx) = status;
+		} else if (type == REPLAY_COVERAGE) {
+			uint64_t len;
+			if (!read_all(fd, &len, sizeof(len)))
+				break;
+
+			std::string coverage(len, '\0');
+			if (!read_all(fd, &coverage[0], len))
+				break;
+			merge_coverage(coverage);
+		} else {
+			throw std::runtime_error("invalid record from replay worker");
+		}
+	}
+
+	close(fd);
+}
+
+// Shard of the test cases replayed by this process, every jobs-th test
+// case starting at the first one (see symbolic_exploration::fork_server).
+struct ReplayShard {
+	const std::vector<std::string> *tests;
+	size_t first;
+	size_t jobs;
+	std::vector<int> *results;
+	int fd; // Pipe to the parent of a replay worker, -1 otherwise.
+};
+
+static std::optional<ReplayShard> replay_shard;
+
+// Pipe to the fork server and replayed test case of a process forked
+// by the fork server, the pipe is -1 in all other processes.
+static int replay_fd = -1;
+static size_t replay_index = 0;
+
+static std::optional<clover::ConcreteStore>
+load_test(const std::string &fp)
+{
+	try {
+		std::ifstream file(fp);
+		if (!file.is_open())
+			throw std::runtime_error("failed to open " + fp);
+		return clover::TestCase::fromFile(symbolic_context.solver.symbols, fp, file);
+	} catch (const std::exception &e) {
+		std::cerr << fp << ": " << e.what() << std::endl;
+		return std::nullopt;
+	}
+}
+
+// Replay a test case of the shard in a process forked from the
+// elaborated platform. Returns true in the forked process, which
+// executes the simulation, and false in the fork server once the
+// result and the coverage of the test case were collected.
+static bool
+fork_test(ReplayShard &shard, size_t idx)
+{
+	auto &fp = shard.tests->at(idx);
+	auto store = load_test(fp);
+	if (!store.has_value())
+		return false;
+
+	int fds[2];
+	if (pipe(fds) == -1)
+		throw std::system_error(errno, std::generic_category());
+
+	// Flush buffered output to prevent duplicating it in the child.
+	std::cout.flush();
+	std::cerr.flush();
+
+	pid_t pid = fork();
+	if (pid == -1) {
+		throw std::system_error(errno, std::generic_category());
+	} else if (pid == 0) {
+		close(fds[0]);
+		if (shard.fd != -1)
+			close(shard.fd);
+		replay_fd = fds[1];
+		replay_index = idx;
+
+		clover::ExecutionContext &ctx = symbolic_context.ctx;
+		ctx.clear();
+		ctx.setupNewValues(*store);
+
+		symbolic_context.trace.reset();
+		symbolic_context.prepare_packet_sequence(0);
+		return true;
+	}
+
+	close(fds[1]);
+	collect_records(fds[0], *shard.results);
+
+	int wstatus;
+	if (waitpid(pid, &wstatus, 0) == -1)
+		throw std::system_error(errno, std::generic_category());
+	if (WIFSIGNALED(wstatus))
+		std::cerr << fp << ": terminated by signal " << WTERMSIG(wstatus) << std::endl;
+
+	return false;
+}
+
+bool
+symbolic_exploration::fork_server(void)
+{
+	if (!replay_shard.has_value())
+		return true;
+
+	// Processes forked by the server execute the simulation as usual.
+	auto shard = *replay_shard;
+	replay_shard.reset();
+
+	for (size_t i = shard.first; i < shard.tests->size(); i += shard.jobs) {
+		if (fork_test(shard, i))
+			return true;
+
+		// Results are reported immediately, thereby allowing the parent
+		// to determine which test case caused a worker to crash.
+		if (shard.fd != -1)
+			write_result(shard.fd, i, shard.results->at(i));
+	}
+
+	return false;
+}
+
+// Replay a shard of the test cases. The platform is elaborated, and the
+// ELF loaded, only once. The elaborated platform is then forked for each
+// test case by the fork server, which is invoked by sc_main.
+static void
+replay_tests(ReplayShard shard, int argc, char **argv)
+{
+	replay_shard = shard;
+	reset_simcontext();
+	int ret = sc_core::sc_elab_and_sim(argc, argv);
+
+	if (replay_fd != -1) {
+		int status = EXIT_SUCCESS;
+		try {
+			write_result(replay_fd, replay_index, ret);
+			write_coverage(replay_fd);
+		} catch (const std::exception &e) {
+			std::cerr << "Replay failed: " << e.what() << std::endl;
+			status = EXIT_FAILURE;
+		}
+
+		close(replay_fd);
+		std::cout.flush();
+		std::cerr.flush();
+		_exit(status); // Don't run atexit functions of the fork server
+	}
+
+	if (replay_shard.has_value()) {
+		replay_shard.reset();
+		std::cerr << "Platform failed before replaying test cases" << std::endl;
+	}
+}
+
+// Replay every jobs-th test case, starting at the given one, and report
+// the results and the merged coverage to the parent process through the
+// given file descriptor.
+[[noreturn]] static void
+replay_worker(int fd, const std::vector<std::string> &tests, size_t first, size_t jobs, int argc, char **argv)
+{
+	int ret = EXIT_SUCCESS;
+
+	try {
+		std::vector<int> results(tests.size(), REPLAY_ERROR);
+		replay_tests(ReplayShard{&tests, first, jobs, &results, fd}, argc, argv);
+		write_coverage(fd);
+	} catch (const std::exception &e) {
+		std::cerr << "Replay worker failed: " << e.what() << std::endl;
+		ret = EXIT_FAILURE;
+	}
+
+	close(fd);
+	std::cout.flush();
+	std::cerr.flush();
+	_exit(ret); // Don't run atexit functions of parent
+}
+
+static unsigned
+get_jobs(void)
+{
+	const char *env;
+	unsigned long jobs;
+
+	if (!(env = getenv(JOBS_ENV)))
+		return 1;
+
+	errno = 0;
+	jobs = strtoul(env, NULL, 10);
+	if (!jobs && errno)
+		throw std::system_error(errno, std::generic_category(), env);
+
+	assert(jobs <= UINT_MAX);
+	return (jobs) ? (unsigned)jobs : 1;
+}
+
+// Replay all test cases matching the given directory or glob pattern,
+// sharded across SYMEX_JOBS worker processes. Each worker elaborates the
+// platform once and forks it for each test case of its shard (see
+// replay_tests), coverage of all workers is merged afterwards.
+static int
+run_tests(const char *pattern, int argc, char **argv)
+{
+	auto tests = collect_tests(pattern);
+	if (tests.empty())
+		throw std::runtime_error("no test cases found for " + std::string(pattern));
+
+	size_t jobs = std::min((size_t)get_jobs(), tests.size());
+	auto start = std::chrono::steady_clock::now();
+
+	// Flush buffered output to prevent duplicating it in workers.
+	std::cout.flush();
+	std::cerr.flush();
+
+	std::vector<std::pair<pid_t, int>> workers;
+	for (size_t w = 1; w < jobs; w++) {
+		int fds[2];
+		if (pipe(fds) == -1)
+			throw std::system_error(errno, std::generic_category());
+
+		pid_t pid = fork();
+		if (pid == -1) {
+			throw std::system_error(errno, std::generic_category());
+		} else if (pid == 0) {
+			close(fds[0]);
+			for (auto worker : workers)
+				close(worker.second);
+			replay_worker(fds[1], tests, w, jobs, argc, argv);
+		}
+
+		close(fds[1]);
+		workers.push_back(std::make_pair(pid, fds[0]));
+	}
+
+	// Test cases not reported by a worker are considered failed.
+	std::vector<int> results(tests.size(), REPLAY_ERROR);
+	replay_tests(ReplayShard{&tests, 0, jobs, &results, -1}, argc, argv);
+
+	for (auto worker : workers) {
+		collect_records(worker.second, results);
+
+		int wstatus;
+		if (waitpid(worker.first, &wstatus, 0) == -1)
+			throw std::system_error(errno, std::generic_category());
+		if (WIFSIGNALED(wstatus))
+			std::cerr << "Replay worker " << worker.first << " terminated by signal " << WTERMSIG(wstatus) << std::endl;
+	}
+	reset_simcontext();
+
+	auto end = std::chrono::steady_clock::now();
+	std::chrono::duration<double> elapsed = end - start;
+
+	size_t failed = 0;
+	std::cout << std::endl << "---" << std::endl;
+	for (size_t i = 0; i < tests.size(); i++) {
+		bool passed = results.at(i) == 0;
+		if (!passed)
+			failed++;
+		std::cout << ((passed) ? "PASS " : "FAIL ") << tests.at(i) << std::endl;
+	}
+
+	std::cout << "Test cases: " << tests.size() << " (" << tests.size() - failed << " passed, " << failed << " failed)" << std::endl;
+	std::cout << "Replay Time: " << elapsed.count() << " seconds with " << jobs << " workers ("
+		<< tests.size() / elapsed.count() << " test cases/s)" << std::endl;
+	dump_coverage();
+
+	return (failed) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
 static unsigned
 get_maxpktseq(void)
 {
@@ -237,24 +862,84 @@ explore_path(int argc, char **argv) {
 	}
 
 	tracer.reset();
-
-	// Reset SystemC simulation context
-	// See also: https://github.com/accellera-official/systemc/issues/8
-	if (sc_core::sc_curr_simcontext) {
-		sc_core::sc_report_handler::release();
-		delete sc_core::sc_curr_simcontext;
-	}
-	sc_core::sc_curr_simcontext = NULL;
+	reset_simcontext();
 
 	int ret;
 	stopped = false;
-	if ((ret = sc_core::sc_elab_and_sim(argc, argv)) && !stopped)
+	hung = false;
+	if ((ret = sc_core::sc_elab_and_sim(argc, argv)) && !stopped && !hung)
 		return ret;
 
+	SymbolicStats::Timer timer(SymbolicStats::COVERAGE);
+	last_novelty = path_novelty();
+	timer.stop();
+
 	if (!stopped)
 		++paths_found;
-	coverage_file << dump_instr_coverage() << std::endl;
+	if (stats_interval && ++stats_pending >= stats_interval) {
+		write_stats();
+		stats_pending = 0;
+	}
+
+	return 0;
+}
+
+// Execute mutations of recently explored inputs without invoking the
+// solver. Mutants are executed in dry-run mode and their branches are
+// only added to the execution tree if they reached new coverage, the
+// solver thus only negates branches which were not flipped by a mutant.
+static int
+fuzz_paths(int argc, char **argv)
+{
+	clover::ExecutionContext &ctx = symbolic_context.ctx;
+	clover::Trace &tracer = symbolic_context.trace;
+	clover::Mutator &mutator = symbolic_context.mutator;
+
+	// Paths stopped by the SPS require enforcing the new constraint
+	// first, which is done by setting up values for the next path.
+	auto store = ctx.getPrevStore();
+	if (!mutations || store.empty() || stopped)
+		return 0;
+	mutator.addSeed(store);
+
+	for (unsigned long i = 0; i < mutations; i++) {
+		// Mutations may violate constraints of the SPS.
+		auto mutant = mutator.mutate();
+		if (!tracer.satisfiesAssume(mutant))
+			continue;
+
+		ctx.clear();
+		ctx.setupNewValues(mutant);
+		symbolic_context.prepare_packet_sequence(pktseqlen);
+
+		symbolic_context.set_dry_run(true);
+		tracer.reset();
+		reset_simcontext();
+
+		int ret;
+		stopped = false;
+		hung = false;
+		ret = sc_core::sc_elab_and_sim(argc, argv);
+		symbolic_context.set_dry_run(false);
+		if (ret && !stopped && !hung)
+			return ret;
+		symbolic_stats.increment(SymbolicStats::MUTANTS);
+
+		SymbolicStats::Timer timer(SymbolicStats::COVERAGE);
+		size_t novelty = path_novelty();
+		timer.stop();
+
+		if (!novelty || stopped)
+			continue;
+
+		symbolic_context.commit();
+		mutator.addSeed(ctx.getPrevStore());
+		symbolic_stats.increment(SymbolicStats::MUTANTS_KEPT);
+		++paths_found;
+	}
 
+	// Values of the last mutant must not be used by the next path.
+	ctx.clear();
 	return 0;
 }
 
@@ -271,8 +956,10 @@ is_stuck_reset(void)
 static bool
 is_stuck(void)
 {
+	// Paths reaching new edges or edge hit counts are considered
+	// progress even if no new branch direction was covered.
 	size_t branches = executed_branches();
-	if (branches == prev_executed_branches)
+	if (branches == prev_executed_branches && !last_novelty)
 		no_new_branch++;
 	else
 		no_new_branch = 0;
@@ -286,6 +973,199 @@ is_stuck(void)
 	return ret;
 }
 
+static void
+write_checkpoint(void)
+{
+	std::string tmp = std::string(checkpoint_path) + ".tmp";
+	std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		throw std::runtime_error("failed to open " + tmp);
+
+	file.write(checkpoint_magic, sizeof(checkpoint_magic) - 1);
+	clover::Serializer out(file, symbolic_context.solver.symbols);
+	out.write((uint64_t)CHECKPOINT_VERSION);
+
+	out.write((uint64_t)paths_found);
+	out.write((uint64_t)errors_found);
+	out.write((uint64_t)errors_stored);
+	out.write((uint64_t)hangs_found);
+	out.write((uint64_t)pktseqlen);
+	out.write((uint64_t)last_novelty);
+	out.write((uint64_t)prev_executed_branches);
+	out.write((uint64_t)no_new_branch);
+	out.write((uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(symbolic_stats.elapsed(SymbolicStats::PATH_SEARCH)).count());
+	out.write(testcase_path->string());
+
+	out.write((uint64_t)error_buckets.size());
+	for (auto &entry : error_buckets) {
+		out.write((uint64_t)entry.first.pc);
+		out.write((uint64_t)entry.first.cause);
+		out.write((uint64_t)entry.first.stack);
+		out.write((uint64_t)entry.second.errors);
+		out.write((uint64_t)entry.second.testcases.size());
+		for (auto &name : entry.second.testcases)
+			out.write(name);
+	}
+
+	symbolic_context.save(out);
+	out.write(checkpoint_coverage());
+
+	file.close();
+	if (file.fail())
+		throw std::runtime_error("failed to write " + tmp);
+
+	// Replace the previous checkpoint atomically.
+	if (rename(tmp.c_str(), checkpoint_path) == -1)
+		throw std::system_error(errno, std::generic_category(), checkpoint_path);
+}
+
+// Write a checkpoint if the checkpoint interval elapsed. Must only be
+// called between two paths, before new values are set up.
+static void
+checkpoint(void)
+{
+	if (!checkpoint_path)
+		return;
+
+	auto now = std::chrono::steady_clock::now();
+	if (now - last_checkpoint < checkpoint_interval)
+		return;
+
+	write_checkpoint();
+	last_checkpoint = now;
+}
+
+static std::filesystem::path
+restore_checkpoint(const char *path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		throw std::runtime_error("failed to open " + std::string(path));
+
+	char magic[sizeof(checkpoint_magic) - 1];
+	if (!file.read(magic, sizeof(magic)) || memcmp(magic, checkpoint_magic, sizeof(magic)))
+		throw std::runtime_error(std::string(path) + ": not a checkpoint file");
+
+	clover::Deserializer in(file, symbolic_context.solver);
+	if (in.readInt() != CHECKPOINT_VERSION)
+		throw std::runtime_error(std::string(path) + ": unsupported checkpoint version");
+
+	paths_found = in.readInt();
+	errors_found = in.readInt();
+	errors_stored = in.readInt();
+	hangs_found = in.readInt();
+	pktseqlen = in.readInt();
+	last_novelty = in.readInt();
+	prev_executed_branches = in.readInt();
+	no_new_branch = in.readInt();
+	symbolic_stats.add(SymbolicStats::PATH_SEARCH, std::chrono::microseconds(in.readInt()));
+	std::filesystem::path testdir = in.readString();
+
+	auto buckets = in.readInt();
+	for (uint64_t i = 0; i < buckets; i++) {
+		symbolic_exploration::ErrorSignature sig;
+		sig.pc = in.readInt();
+		sig.cause = in.readInt();
+		sig.stack = in.readInt();
+
+		auto &bucket = error_buckets[sig];
+		bucket.errors = in.readInt();
+		auto testcases = in.readInt();
+		for (uint64_t j = 0; j < testcases; j++)
+			bucket.testcases.push_back(in.readString());
+	}
+
+	symbolic_context.load(in);
+	restore_coverage(in.readString());
+
+	resumed = true;
+	return testdir;
+}
+
+static void
+setup_checkpoint(void)
+{
+	if (!(checkpoint_path = getenv(CHECKPOINT_ENV)))
+		return;
+
+	char *interval = getenv(CHECKPOINT_INTERVAL_ENV);
+	if (interval) {
+		errno = 0;
+		auto seconds = strtoul(interval, NULL, 10);
+		if (!seconds && errno)
+			throw std::system_error(errno, std::generic_category(), interval);
+		checkpoint_interval = std::chrono::seconds(seconds);
+	}
+
+	last_checkpoint = std::chrono::steady_clock::now();
+}
+
+static void
+setup_seed(void)
+{
+	char *env = getenv(SEED_ENV);
+	if (!env) {
+		// Use current time as seed for random generators
+		seed = (unsigned int)std::time(nullptr);
+	} else {
+		errno = 0;
+		unsigned long value = strtoul(env, NULL, 10);
+		if (!value && errno)
+			throw std::system_error(errno, std::generic_category(), env);
+		seed = (unsigned int)value;
+	}
+
+	symbolic_context.seed(seed);
+}
+
+static unsigned long
+get_limit(const char *name)
+{
+	const char *env;
+	unsigned long limit;
+
+	if (!(env = getenv(name)))
+		return 0;
+
+	errno = 0;
+	limit = strtoul(env, NULL, 10);
+	if (!limit && errno)
+		throw std::system_error(errno, std::generic_category(), env);
+
+	return limit;
+}
+
+static void
+setup_budget(void)
+{
+	auto &budget = symbolic_exploration::path_budget;
+
+	budget.instructions = get_limit(MAXINSTR_ENV);
+	budget.simtime = get_limit(MAXSIMTIME_ENV);
+	budget.walltime = std::chrono::milliseconds(get_limit(MAXWALLTIME_ENV));
+
+	unsigned long loops = get_limit(MAXLOOP_ENV);
+	assert(loops <= UINT_MAX);
+	budget.loops = (unsigned)loops;
+}
+
+static void
+setup_errors(void)
+{
+	if (getenv(ERRBUCKET_ENV))
+		bucket_size = get_limit(ERRBUCKET_ENV);
+
+	// A non-numeric value exits on the first error.
+	if (getenv(ERR_EXIT_ENV))
+		errexit = std::max(get_limit(ERR_EXIT_ENV), 1UL);
+}
+
+static void
+setup_mutations(void)
+{
+	mutations = get_limit(MUTATIONS_ENV);
+}
+
 static int
 explore_paths(int argc, char **argv)
 {
@@ -295,7 +1175,8 @@ explore_paths(int argc, char **argv)
 	// Perform bounded symbolic execution on packet sequence length.
 	// Unless maxpktseq is zero in which case the exploration is unbounded.
 	maxpktseq = get_maxpktseq();
-	pktseqlen = 1;
+	if (!resumed)
+		pktseqlen = 1;
 
 	bool foundAssig = true; // initially random (handled by setupNewValues)
 	for (;;) {
@@ -303,12 +1184,22 @@ explore_paths(int argc, char **argv)
 		// discover a new path through the software by negating it.
 		if (foundAssig) {
 			do {
+				// Checkpoints are written after a path has been
+				// explored, continue by negating a branch condition.
+				if (resumed) {
+					resumed = false;
+					continue;
+				}
+
 				symbolic_context.prepare_packet_sequence(pktseqlen);
 				if ((ret = explore_path(argc, argv)))
 					return ret;
 
 				if (is_stuck())
 					break;
+				if ((ret = fuzz_paths(argc, argv)))
+					return ret;
+				checkpoint();
 			} while (setupNewValues());
 		}
 
@@ -380,18 +1271,30 @@ symbolic_explore(int argc, char **argv)
 	// Mempool does not seem to free all memory, disable it.
 	setenv("SYSTEMC_MEMPOOL_DONT_USE", "1", 0);
 
-	// Use current time as seed for random generator
-	std::srand(std::time(nullptr));
+	setup_seed();
+	setup_budget();
 
+	// A test case directory or glob pattern is replayed in batch mode.
 	char *testcase = getenv(TESTCASE_ENV);
-	if (testcase)
+	if (testcase && std::filesystem::is_regular_file(testcase))
 		return run_test(testcase, argc, argv);
-	create_testdir();
+	else if (testcase)
+		return run_tests(testcase, argc, argv);
+
+	std::optional<std::filesystem::path> testdir;
+	char *resume = getenv(RESUME_ENV);
+	if (resume)
+		testdir = restore_checkpoint(resume);
+	create_testdir(testdir);
 
 	// Set report handler for detecting errors
 	sc_core::sc_report_handler::set_handler(report_handler);
 
 	setup_timeout();
+	setup_errors();
+	setup_mutations();
+	setup_checkpoint();
+	setup_stats();
 	int ret = explore_paths(argc, argv);
 	dump_stats();
 
@@ -18,10 +18,52 @@
 #ifndef RISCV_ISA_SYMBOLIC_EXPLORE_H
 #define RISCV_ISA_SYMBOLIC_EXPLORE_H
 
+#include <chrono>
+#include <string>
+#include <tuple>
+#include <stdint.h>
+
 int symbolic_explore(int argc, char **argv);
 
 namespace symbolic_exploration {
+	// Execution limits of a single path, enforced by the ISS. A limit
+	// of zero disables the corresponding check.
+	struct PathBudget {
+		uint64_t instructions = 0;              // Retired instructions
+		uint64_t simtime = 0;                   // Simulated time in milliseconds
+		std::chrono::milliseconds walltime{0};  // Wall-clock time
+		unsigned loops = 0;                     // Recurrences of a loop state
+	};
+
+	extern PathBudget path_budget;
+
+	// Signature of an error, errors with the same signature are
+	// considered duplicates (see SYMEX_ERRBUCKET).
+	struct ErrorSignature {
+		static constexpr uint32_t NO_TRAP = UINT32_MAX;
+
+		uint32_t pc = 0;          // Instruction signaling the error
+		uint32_t cause = NO_TRAP; // Cause of the innermost trap handler
+		uint64_t stack = 0;       // Hash of the call stack
+
+		bool operator<(const ErrorSignature &other) const {
+			return std::tie(pc, cause, stack) < std::tie(other.pc, other.cause, other.stack);
+		}
+	};
+
+	// Signal an error of the executed software.
+	void report_error(const ErrorSignature &signature);
+
 	void stop_assume(void);
+
+	// Terminate the current path and record its input as hang.
+	void stop_hang(const std::string &reason);
+
+	// Invoked by sc_main after elaboration, before sc_start. When
+	// replaying test cases, the elaborated platform is forked for
+	// each test case. Returns false if the simulation must not be
+	// started, i.e. in the process which forked the test cases.
+	bool fork_server(void);
 };
 
 #endif
@@ -51,26 +51,72 @@ to_byte_size(uint64_t bitsize)
 	return bytesize;
 }
 
-SymbolicFormat::SymbolicFormat(SymbolicContext &_ctx, std::istream &stream)
+SymbolicFormat::SymbolicFormat(SymbolicContext &_ctx, const std::string &response)
   : ctx(_ctx.ctx), solver(_ctx.solver)
 {
-	data = bencode::decode(stream, bencode::no_check_eof);
-	if (stream.bad())
-		throw std::runtime_error("failed to read bencode data from socket");
+	// The decoded data references the response, it must thus
+	// not be used after the constructor returned.
+	auto data = bencode::decode_view(response);
 
-	input = get_input();
-	offset = input->getWidth();
+	get_input(data);
+	index = 0;
 
 	return;
 }
 
-std::shared_ptr<clover::ConcolicValue>
-SymbolicFormat::make_symbolic(std::string name, uint64_t bitsize, size_t bytesize)
+void
+SymbolicFormat::append_piece(Value piece)
+{
+	unsigned width = piece->getWidth();
+	assert(width <= CHAR_BIT);
+
+	if (!pending) {
+		if (width == CHAR_BIT)
+			bytes.push_back(piece);
+		else
+			pending = piece;
+		return;
+	}
+
+	unsigned need = CHAR_BIT - pending->getWidth();
+	if (width < need) {
+		pending = pending->concat(piece);
+		return;
+	}
+
+	// Only extract from the piece itself, never from a Concat.
+	unsigned rem = width - need;
+	bytes.push_back(pending->concat((rem) ? piece->extract(rem, need) : piece));
+	pending = (rem) ? piece->extract(0, rem) : nullptr;
+}
+
+SymbolicFormat::Value
+SymbolicFormat::make_symbolic(const std::string &name, uint64_t bitsize, size_t bytesize, std::vector<Value> &pieces)
 {
 	auto idx = symbolic_context.current_index();
 	std::string field_name = "pkt" + std::to_string(idx) + ":" + name;
 
-	auto symbolic_value = ctx.getSymbolicBytes(field_name, bytesize);
+	// Same as ExecutionContext::getSymbolicBytes, but retain the
+	// single bytes for creating the pieces.
+	Value symbolic_value = nullptr;
+	std::vector<Value> symbytes;
+	auto &ids = solver.symbols.internBytes(field_name, bytesize);
+	field_ids.assign(ids.begin(), ids.begin() + bytesize);
+	for (size_t i = 0; i < bytesize; i++) {
+		auto symbyte = ctx.getSymbolicByte(ids[i]);
+
+		symbytes.push_back(symbyte);
+		symbolic_value = (symbolic_value) ? symbyte->concat(symbolic_value) : symbyte;
+	}
+
+	// The first byte is the least significant one.
+	for (size_t i = bytesize; i > 0; i--) {
+		auto symbyte = symbytes.at(i - 1);
+		if (i == bytesize && HAS_PADDING(bitsize))
+			symbyte = symbyte->extract(0, bitsize % CHAR_BIT);
+		pieces.push_back(symbyte);
+	}
+
 	if (HAS_PADDING(bitsize))
 		symbolic_value = symbolic_value->extract(0, bitsize);
 
@@ -78,8 +124,30 @@ SymbolicFormat::make_symbolic(std::string name, uint64_t bitsize, size_t bytesiz
 	return symbolic_value;
 }
 
-std::shared_ptr<clover::ConcolicValue>
-SymbolicFormat::get_value(bencode::list list, std::string name, uint64_t bitsize)
+// Add constants of the field's width, which are compared against the
+// field by the given constraint, to the dictionary of the mutator.
+void
+SymbolicFormat::add_tokens(klee::ref<klee::Expr> constraint, uint64_t bitsize)
+{
+	if (bitsize > 64)
+		return;
+
+	std::vector<klee::ref<klee::Expr>> stack;
+	stack.push_back(constraint);
+	while (!stack.empty()) {
+		auto e = stack.back();
+		stack.pop_back();
+
+		auto ce = klee::dyn_cast<klee::ConstantExpr>(e);
+		if (ce && ce->getWidth() == bitsize)
+			symbolic_context.mutator.addToken(field_ids, ce->getZExtValue());
+		for (unsigned i = 0; i < e->getNumKids(); i++)
+			stack.push_back(e->getKid(i));
+	}
+}
+
+SymbolicFormat::Value
+SymbolicFormat::get_value(const bencode::list_view &list, const std::string &name, uint64_t bitsize, std::vector<Value> &pieces)
 {
 	size_t bytesize;
 	int is_symbolic;
@@ -100,29 +168,30 @@ SymbolicFormat::get_value(bencode::list list, std::string name, uint64_t bitsize
 	// length of the specified bytevector.
 
 	is_symbolic = -1;
-	for (auto elem : list) {
+	for (auto &elem : list) {
 		if (is_symbolic == -1) {
-			is_symbolic = std::get_if<bencode::string>(&elem) != nullptr;
+			is_symbolic = std::get_if<bencode::string_view>(&elem) != nullptr;
 			if (is_symbolic)
-				symbolic_value = make_symbolic(name, bitsize, bytesize);
+				symbolic_value = make_symbolic(name, bitsize, bytesize, pieces);
 		}
 
 		if (is_symbolic) {
-			bencode::string constraint;
+			bencode::string_view constraint;
 			try {
-				constraint = std::get<bencode::string>(elem);
+				constraint = std::get<bencode::string_view>(elem);
 			} catch (const std::bad_variant_access&) {
 				return nullptr;
 			}
-			auto bv = solver.fromString(env, constraint);
+			auto bv = solver.fromString(env, std::string(constraint));
+			add_tokens(bv->expr, bitsize);
 
 			// Enforce parsed constraint via symbolic_context.
 			// TODO: Build full Env first and constrain after.
 			symbolic_context.assume(bv);
 		} else { // is_concrete
-			bencode::integer intval;
+			bencode::integer_view intval;
 			try {
-				intval = std::get<bencode::integer>(elem);
+				intval = std::get<bencode::integer_view>(elem);
 			} catch (const std::bad_variant_access&) {
 				return nullptr;
 			}
@@ -133,7 +202,7 @@ SymbolicFormat::get_value(bencode::list list, std::string name, uint64_t bitsize
 	}
 
 	if (is_symbolic == -1) // unconstrained symbolic value
-		return make_symbolic(name, bitsize, bytesize);
+		return make_symbolic(name, bitsize, bytesize, pieces);
 
 	if (is_symbolic) {
 		return symbolic_value;
@@ -141,6 +210,14 @@ SymbolicFormat::get_value(bencode::list list, std::string name, uint64_t bitsize
 		if (concrete_value.size() != bytesize)
 			return nullptr;
 
+		// The first byte is the most significant one.
+		for (size_t i = 0; i < bytesize; i++) {
+			auto byte = solver.BVC(std::nullopt, concrete_value.at(i));
+			if (i == 0 && HAS_PADDING(bitsize))
+				byte = byte->extract(0, bitsize % CHAR_BIT);
+			pieces.push_back(byte);
+		}
+
 		auto bvc = solver.BVC(concrete_value.data(), concrete_value.size(), true);
 		if (HAS_PADDING(bitsize))
 			bvc = bvc->extract(0, bitsize);
@@ -148,61 +225,45 @@ SymbolicFormat::get_value(bencode::list list, std::string name, uint64_t bitsize
 	}
 }
 
-std::shared_ptr<clover::ConcolicValue>
-SymbolicFormat::get_input(void)
+void
+SymbolicFormat::get_input(const bencode::data_view &data)
 {
-	std::shared_ptr<clover::ConcolicValue> r = nullptr;
+	std::vector<Value> pieces;
 
-	auto list = std::get<bencode::list>(data);
+	auto &list = std::get<bencode::list_view>(data);
 	for (auto &elem : list) {
-		auto field = std::get<bencode::list>(elem);
+		auto &field = std::get<bencode::list_view>(elem);
 		if (field.size() != 3)
 			throw std::invalid_argument("invalid bencode field");
 
-		auto name = std::get<bencode::string>(field[0]);
-		auto size = std::get<bencode::integer>(field[1]);
-		auto list = std::get<bencode::list>(field[2]);
+		std::string name(std::get<bencode::string_view>(field[0]));
+		auto size = std::get<bencode::integer_view>(field[1]);
+		auto &list = std::get<bencode::list_view>(field[2]);
 
-		auto v = get_value(list, name, (uint64_t)size);
+		pieces.clear();
+		auto v = get_value(list, name, (uint64_t)size, pieces);
 		if (!v)
 			throw std::invalid_argument("invalid bencode value format");
 
-		if (!r) {
-			r = v;
-			continue;
-		}
-		r = r->concat(v);
+		for (auto &piece : pieces)
+			append_piece(piece);
 	}
 
-	assert(r != nullptr);
-	assert(r->getWidth() % CHAR_BIT == 0);
-
-	return r;
+	assert(!bytes.empty());
+	assert(pending == nullptr);
 }
 
 std::shared_ptr<clover::ConcolicValue>
 SymbolicFormat::next_byte(void)
 {
-	if (offset == 0)
+	if (index >= bytes.size())
 		return nullptr;
 
-	assert(offset % CHAR_BIT == 0);
-	offset -= CHAR_BIT;
-
-	auto byte = input->extract(offset, CHAR_BIT);
-	assert(byte->getWidth() == CHAR_BIT);
-
-	return byte;
+	return bytes.at(index++);
 }
 
 size_t
 SymbolicFormat::remaining_bytes(void)
 {
-	if (offset == 0)
-		return 0; // empty
-
-	auto width = input->getWidth();
-	assert(width % CHAR_BIT == 0);
-
-	return (width - (width - offset)) / CHAR_BIT;
+	return bytes.size() - index;
 }
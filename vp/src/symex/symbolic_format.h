@@ -22,7 +22,8 @@
 #include <stdint.h>
 #include <symbolic_context.h>
 #include <clover/clover.h>
-#include <istream>
+#include <string>
+#include <vector>
 
 #include "bencode.hpp"
 
@@ -32,22 +33,33 @@ private:
 	clover::Solver &solver;
 	clover::Solver::Env env;
 
-	bencode::data data;
+	typedef std::shared_ptr<clover::ConcolicValue> Value;
 
-	std::shared_ptr<clover::ConcolicValue> input;
-	unsigned offset;
+	// Bytes of the message in the order they are passed to the
+	// software. Fields are split into pieces of at most one byte
+	// (in MSB-first order) during decoding, which are then
+	// assembled into the bytes of this vector.
+	std::vector<Value> bytes;
+	size_t index;
 
-	std::shared_ptr<clover::ConcolicValue> get_value(bencode::list list, std::string name, uint64_t bitsize);
-	std::shared_ptr<clover::ConcolicValue> make_symbolic(std::string name, uint64_t bitsize, size_t bytesize);
-	std::shared_ptr<clover::ConcolicValue> get_input(void);
+	// Bits of the last piece which did not fill a byte yet.
+	Value pending;
+
+	// Identifiers of the bytes of the last symbolic field, the
+	// first byte is the least significant one.
+	std::vector<clover::SymbolID> field_ids;
+
+	void append_piece(Value piece);
+	void add_tokens(klee::ref<klee::Expr> constraint, uint64_t bitsize);
+	Value get_value(const bencode::list_view &list, const std::string &name, uint64_t bitsize, std::vector<Value> &pieces);
+	Value make_symbolic(const std::string &name, uint64_t bitsize, size_t bytesize, std::vector<Value> &pieces);
+	void get_input(const bencode::data_view &data);
 
 public:
-	SymbolicFormat(SymbolicContext &_ctx, std::istream &stream);
+	// Create a new format from a bencode encoded SPS response.
+	SymbolicFormat(SymbolicContext &_ctx, const std::string &response);
 
-	/* XXX: Could be implemented as an Iterator.
-	 *
-	 * Also: KLEE Array Type would be useful here ReadLSB, ReadMSB, …
-	 * See:  https://gitlab.informatik.uni-bremen.de/riscv/clover/-/issues/7 */
+	/* XXX: Could be implemented as an Iterator. */
 	std::shared_ptr<clover::ConcolicValue> next_byte(void);
 	size_t remaining_bytes(void);
 };
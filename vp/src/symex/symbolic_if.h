@@ -18,12 +18,17 @@
 #ifndef RISCV_ISA_SYMBOLIC_IF_H
 #define RISCV_ISA_SYMBOLIC_IF_H
 
+#include "symbolic_explore.h"
+
 struct symbolic_iss_if {
 	virtual ~symbolic_iss_if(void) {}
 	virtual void make_symbolic(uint32_t addr, size_t size) = 0;
 
 	virtual void sys_exit(void) = 0;
 	virtual void sys_processed_packet(void) = 0;
+
+	// Signature of an error signaled by the software at this point.
+	virtual symbolic_exploration::ErrorSignature error_signature(void) = 0;
 };
 
 #endif
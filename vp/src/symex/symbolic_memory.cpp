@@ -15,41 +15,108 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "symbolic_memory.h"
 
 SymbolicMemory::SymbolicMemory(sc_core::sc_module_name, clover::Solver &_solver, size_t _size)
     : solver(_solver), size(_size), memory(solver)
 {
+	// Use calloc(3) to avoid touching pages which are never accessed.
+	data = (uint8_t *)calloc(size, sizeof(uint8_t));
+	shadow = (uint64_t *)calloc((size + 63) / 64, sizeof(uint64_t));
+	if (!data || !shadow)
+		throw std::bad_alloc();
+
 	tsock.register_b_transport(this, &SymbolicMemory::transport);
 	tsock.register_transport_dbg(this, &SymbolicMemory::transport_dbg);
 }
 
+SymbolicMemory::~SymbolicMemory(void)
+{
+	free(data);
+	free(shadow);
+}
+
+SymbolicMemoryDMI
+SymbolicMemory::get_dmi(uint64_t start_addr)
+{
+	return SymbolicMemoryDMI::create_start_size_mapping(data, shadow, start_addr, size);
+}
+
+void
+SymbolicMemory::set_symbolic(uint64_t addr, bool symbolic)
+{
+	uint64_t mask = (uint64_t)1 << (addr % 64);
+	if (symbolic)
+		shadow[addr / 64] |= mask;
+	else
+		shadow[addr / 64] &= ~mask;
+}
+
+bool
+SymbolicMemory::is_symbolic(uint64_t addr)
+{
+	return shadow[addr / 64] & ((uint64_t)1 << (addr % 64));
+}
+
 void
 SymbolicMemory::load_data(const char *src, uint64_t dst_addr, size_t n)
 {
-	for (size_t i = 0; i < n; i++) {
-		auto byte = solver.BVC(std::nullopt, (uint8_t)src[i]);
-		memory.store(dst_addr + i, byte, 1);
-	}
+	assert(dst_addr + n <= size);
+
+	memcpy(&data[dst_addr], src, n);
+	for (size_t i = 0; i < n; i++)
+		set_symbolic(dst_addr + i, false);
 }
 
 void
 SymbolicMemory::load_zero(uint64_t dst_addr, size_t n)
 {
-	auto zero = solver.BVC(std::nullopt, (uint8_t)0);
+	assert(dst_addr + n <= size);
+
+	memset(&data[dst_addr], 0, n);
 	for (size_t i = 0; i < n; i++)
-		memory.store(dst_addr + i, zero, 1);
+		set_symbolic(dst_addr + i, false);
 }
 
 unsigned
 SymbolicMemory::read_data(tlm::tlm_generic_payload &trans)
 {
+	auto addr = trans.get_address();
 	auto size = trans.get_data_length();
 
-	auto data = memory.load(trans.get_address(), size);
-	SymbolicExtension *extension = new SymbolicExtension(data);
+	bool symbolic = false;
+	for (size_t i = 0; i < size; i++) {
+		if (is_symbolic(addr + i)) {
+			symbolic = true;
+			break;
+		}
+	}
 
-	solver.BVCToBytes(data, trans.get_data_ptr(), trans.get_data_length());
+	// Only attach an extension if at least one byte is symbolic,
+	// the initiator creates a concrete value from the data pointer
+	// if no extension is present.
+	memcpy(trans.get_data_ptr(), &data[addr], size);
+	if (!symbolic)
+		return size;
+
+	std::shared_ptr<clover::ConcolicValue> value = nullptr;
+	for (size_t i = 0; i < size; i++) {
+		std::shared_ptr<clover::ConcolicValue> byte;
+		if (is_symbolic(addr + i))
+			byte = memory.load(addr + i, 1);
+		else
+			byte = solver.BVC(std::nullopt, data[addr + i]);
+
+		if (!value)
+			value = byte;
+		else
+			value = byte->concat(value);
+	}
+
+	SymbolicExtension *extension = new SymbolicExtension(value);
 	trans.set_extension(extension);
 
 	return size;
@@ -58,20 +125,35 @@ SymbolicMemory::read_data(tlm::tlm_generic_payload &trans)
 unsigned
 SymbolicMemory::write_data(tlm::tlm_generic_payload &trans)
 {
-	std::shared_ptr<clover::ConcolicValue> value;
+	auto addr = trans.get_address();
 	auto size = trans.get_data_length();
 
+	// The concrete part is always present in the data pointer.
+	memcpy(&data[addr], trans.get_data_ptr(), size);
+
 	SymbolicExtension *extension;
 	trans.get_extension(extension);
 
+	std::shared_ptr<clover::ConcolicValue> value = nullptr;
 	if (extension)
 		value = extension->getValue();
-	else
-		value = solver.BVC(trans.get_data_ptr(), size);
+	if (!value || !value->symbolic.has_value()) {
+		for (size_t i = 0; i < size; i++)
+			set_symbolic(addr + i, false);
+		return size;
+	}
 
-	// ConcolicValue may have getWith() > size * 8, however,
+	// ConcolicValue may have getWidth() > size * 8, however,
 	// the ConcolicMemory::store will only store size bytes.
-	memory.store(trans.get_address(), value, size);
+	memory.store(addr, value, size);
+
+	// Bytes of a symbolic value may still be constant (e.g. due to
+	// a zero extension). Those are tracked as concrete bytes.
+	for (size_t i = 0; i < size; i++) {
+		auto byte = memory.load(addr + i, 1);
+		auto expr = (*byte->symbolic)->expr;
+		set_symbolic(addr + i, !klee::isa<klee::ConstantExpr>(expr));
+	}
 
 	return size;
 }
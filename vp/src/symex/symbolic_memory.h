@@ -28,19 +28,31 @@
 #include <memory>
 
 #include "symbolic_extension.h"
+#include "symbolic_dmi.h"
 
 class SymbolicMemory : public sc_core::sc_module, public load_if {
 private:
 	clover::Solver &solver;
 
+	void set_symbolic(uint64_t addr, bool symbolic);
+	bool is_symbolic(uint64_t addr);
+
 public:
 	size_t size;
+
+	// Concrete values of all bytes, symbolic bytes are additionally
+	// tracked in the ConcolicMemory and marked in the shadow bitmap.
+	uint8_t *data;
+	uint64_t *shadow;
 	clover::ConcolicMemory memory;
 
 	typedef std::shared_ptr<clover::ConcolicValue> Data;
 	tlm_utils::simple_target_socket<SymbolicMemory> tsock;
 
 	SymbolicMemory(sc_core::sc_module_name, clover::Solver &_solver, size_t _size);
+	~SymbolicMemory(void);
+
+	SymbolicMemoryDMI get_dmi(uint64_t start_addr);
 
 	void load_data(const char *src, uint64_t dst_addr, size_t n) override;
 	void load_zero(uint64_t dst_addr, size_t n) override;
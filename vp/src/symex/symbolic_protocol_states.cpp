@@ -17,6 +17,8 @@
 
 #include <optional>
 #include <fstream>
+#include <iostream>
+#include <iterator>
 #include <system_error>
 
 #include <assert.h>
@@ -25,11 +27,16 @@
 #include <stdint.h>
 #include <unistd.h>
 
+#include <ctype.h>
+#include <string.h>
+
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 
 #include "bencode.hpp"
 #include "symbolic_protocol_states.h"
+#include "symbolic_stats.h"
 
 static std::optional<socklen_t>
 str2addr(const char *host, const char *service, struct sockaddr *dest)
@@ -61,57 +68,258 @@ str2addr(const char *host, const char *service, struct sockaddr *dest)
 	return len;
 }
 
-ProtocolStates::ProtocolStates(SymbolicContext &_ctx, std::string host, std::string service)
-  : ctx(_ctx)
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static uint64_t
+fnv1a(uint64_t hash, const void *buf, size_t len)
+{
+	const uint8_t *p = (const uint8_t *)buf;
+	for (size_t i = 0; i < len; i++) {
+		hash ^= p[i];
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+static int
+connect_unix(const std::string &path)
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	memset(&addr, '\0', sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(addr.sun_path))
+		throw std::invalid_argument("unix socket path too long: " + path);
+	strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+	if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+		throw std::system_error(errno, std::generic_category());
+	if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == -1)
+		throw std::runtime_error("couldn't connect to SPS server");
+
+	return fd;
+}
+
+static int
+connect_inet(const std::string &host, const std::string &service)
 {
-	int infd, outfd;
 	sockaddr_storage addr;
 	std::optional<socklen_t> len;
+	int fd;
 
 	len = str2addr(host.c_str(), service.c_str(), (struct sockaddr*)&addr);
 	if (!len.has_value())
 		throw std::system_error(EADDRNOTAVAIL, std::generic_category());
 
-	if ((sockfd = socket(addr.ss_family, SOCK_STREAM, 0)) == -1)
+	if ((fd = socket(addr.ss_family, SOCK_STREAM, 0)) == -1)
 		throw std::system_error(errno, std::generic_category());
-	if (connect(sockfd, (struct sockaddr*)&addr, *len) == -1)
+	if (connect(fd, (struct sockaddr*)&addr, *len) == -1)
 		throw std::runtime_error("couldn't connect to SPS server");
 
-	//
-	// See https://gcc.gnu.org/onlinedocs/libstdc++/manual/ext_io.html
-	//
+	return fd;
+}
 
-	if ((infd = dup(sockfd)) == -1)
-		throw std::system_error(errno, std::generic_category());
-	inbuf = new __gnu_cxx::stdio_filebuf<char>(infd, std::ios::binary|std::ios::in);
-	sockin = new std::istream(inbuf);
+// Returns the length of the bencode value at the start of the
+// buffer or std::nullopt if the buffer doesn't contain a complete
+// value yet. Values are only scanned, not decoded.
+static std::optional<size_t>
+bencode_length(const char *buf, size_t len)
+{
+	size_t pos = 0;
+	size_t depth = 0;
 
-	if ((outfd = dup(sockfd)) == -1)
-		throw std::system_error(errno, std::generic_category());
-	outbuf = new __gnu_cxx::stdio_filebuf<char>(outfd, std::ios::binary|std::ios::out);
-	sockout = new std::ostream(outbuf);
+	do {
+		if (pos >= len)
+			return std::nullopt;
 
-	// close original sockfd as it has been dup'ed above.
-	if (close(sockfd) == -1)
-		throw std::system_error(errno, std::generic_category());
+		char c = buf[pos];
+		if (c == 'l' || c == 'd') {
+			depth++;
+			pos++;
+		} else if (c == 'e') {
+			if (depth == 0)
+				throw std::invalid_argument("unexpected end of bencode list");
+			depth--;
+			pos++;
+		} else if (c == 'i') {
+			auto end = (const char *)memchr(buf + pos, 'e', len - pos);
+			if (!end)
+				return std::nullopt;
+			pos = (end - buf) + 1;
+		} else if (isdigit(c)) {
+			auto colon = (const char *)memchr(buf + pos, ':', len - pos);
+			if (!colon)
+				return std::nullopt;
+
+			size_t n = 0;
+			for (const char *p = buf + pos; p < colon; p++) {
+				if (!isdigit(*p))
+					throw std::invalid_argument("invalid bencode string length");
+				n = n * 10 + (*p - '0');
+			}
+
+			pos = (colon - buf) + 1 + n;
+			if (pos > len)
+				return std::nullopt;
+		} else {
+			throw std::invalid_argument("invalid bencode data");
+		}
+	} while (depth > 0);
+
+	return pos;
+}
+
+ProtocolStates::ProtocolStates(SymbolicContext &_ctx, std::string host, std::string service,
+                               std::string cache_path, bool _validate)
+  : ctx(_ctx), rxbuf(4096), history_hash(FNV_OFFSET_BASIS), owner(getpid()), validate(_validate)
+{
+	const std::string unix_prefix = "unix:";
+	if (host.compare(0, unix_prefix.size(), unix_prefix) == 0)
+		sockfd = connect_unix(host.substr(unix_prefix.size()));
+	else
+		sockfd = connect_inet(host, service);
+
+	if (!cache_path.empty())
+		load_cache(cache_path);
 }
 
 ProtocolStates::~ProtocolStates(void)
 {
-	delete sockin;
-	delete inbuf;
+	close(sockfd);
+}
+
+void
+ProtocolStates::load_cache(std::string path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (file.is_open()) {
+		std::string content((std::istreambuf_iterator<char>(file)),
+		                    std::istreambuf_iterator<char>());
+
+		// The file consists of multiple bencode lists, one per
+		// cache entry, containing the key and the response.
+		auto begin = content.cbegin();
+		while (begin != content.cend()) {
+			auto entry = std::get<bencode::list>(bencode::decode(begin, content.cend()));
+			if (entry.size() != 2)
+				throw std::invalid_argument("invalid SPS cache entry in " + path);
+
+			auto key = std::stoull(std::get<bencode::string>(entry[0]));
+			cache[key] = std::get<bencode::string>(entry[1]);
+		}
+	}
+
+	cachefile.open(path, std::ios::binary|std::ios::app);
+	if (!cachefile.is_open())
+		throw std::runtime_error("failed to open SPS cache file " + path);
+}
+
+void
+ProtocolStates::store_cache(uint64_t key, const std::string &response)
+{
+	cache[key] = response;
+	if (!cachefile.is_open())
+		return;
+
+	bencode::encode(cachefile, bencode::list{std::to_string(key), response});
+	cachefile.flush();
+}
+
+void
+ProtocolStates::send_request(void)
+{
+	size_t written = 0;
+	while (written < txbuf.size()) {
+		ssize_t r = send(sockfd, txbuf.data() + written, txbuf.size() - written, MSG_NOSIGNAL);
+		if (r == -1) {
+			if (errno == EINTR)
+				continue;
+			throw std::system_error(errno, std::generic_category(), "failed to write to SPS socket");
+		}
+		written += r;
+	}
+}
+
+std::string
+ProtocolStates::recv_response(void)
+{
+	std::optional<size_t> len;
+	while (!(len = bencode_length(rxbuf.data(), rxlen)).has_value()) {
+		if (rxlen == rxbuf.size())
+			rxbuf.resize(rxbuf.size() * 2);
+
+		ssize_t r = recv(sockfd, rxbuf.data() + rxlen, rxbuf.size() - rxlen, 0);
+		if (r == -1) {
+			if (errno == EINTR)
+				continue;
+			throw std::system_error(errno, std::generic_category(), "failed to read from SPS socket");
+		} else if (r == 0) {
+			throw std::runtime_error("SPS server closed connection");
+		}
+		rxlen += r;
+	}
+
+	std::string response(rxbuf.data(), *len);
+	rxlen -= *len;
+	memmove(rxbuf.data(), rxbuf.data() + *len, rxlen);
+
+	return response;
+}
+
+std::string
+ProtocolStates::transmit(const std::string &msg)
+{
+	// Encode bencode::list{SPS_DATA, msg} directly into txbuf.
+	txbuf.clear();
+	txbuf += "li" + std::to_string(SPS_DATA) + "e";
+	txbuf += std::to_string(msg.size()) + ":";
+	txbuf += msg;
+	txbuf += "e";
+
+	symbolic_stats.increment(SymbolicStats::SPS_REQUESTS);
+	send_request();
+	return recv_response();
+}
+
+std::string
+ProtocolStates::sync(void)
+{
+	SymbolicStats::Timer timer(SymbolicStats::SPS);
+	assert(!history.empty());
 
-	delete sockout;
-	delete outbuf;
+	if (owner != getpid()) {
+		owner = getpid();
+		server_pos = std::nullopt;
+	}
+
+	if (!server_pos.has_value()) {
+		// Encode bencode::list{SPS_RST, 0x0} into txbuf.
+		txbuf = "li" + std::to_string(SPS_RST) + "ei0ee";
+		send_request();
+		server_pos = 0;
+	}
+
+	// Replay messages answered from the cache, the responses
+	// to these messages are already known and thus discarded.
+	while (*server_pos < history.size() - 1)
+		transmit(history.at((*server_pos)++));
+
+	(*server_pos)++;
+	return transmit(history.back());
 }
 
 void
 ProtocolStates::reset(void)
 {
-	bencode::encode(*sockout, bencode::list{SPS_RST, 0x0});
-	sockout->flush();
-	if (sockout->bad())
-		throw std::runtime_error("failed reset SPS state machine");
+	// The reset is only send to the server on the next cache miss.
+	if (!server_pos.has_value() || *server_pos > 0)
+		server_pos = std::nullopt;
+
+	history.clear();
+	history_hash = FNV_OFFSET_BASIS;
 
 	// Reset lastMsg
 	lastMsg = nullptr;
@@ -125,16 +333,32 @@ ProtocolStates::send_message(char *buf, size_t size)
 	if (!empty())
 		throw std::runtime_error("previous message has not been fully received");
 
-	// Send message received by client to server.
-	std::string out(buf, size);
-	bencode::encode(*sockout, bencode::list{SPS_DATA, out});
-	sockout->flush();
-	if (sockout->bad())
-		throw std::runtime_error("failed to write bencode data to socket");
+	// Message length is included to prevent ambiguous histories.
+	uint64_t len = size;
+	history_hash = fnv1a(history_hash, &len, sizeof(len));
+	history_hash = fnv1a(history_hash, buf, size);
+	history.push_back(std::string(buf, size));
+
+	std::string response;
+	auto cached = cache.find(history_hash);
+	if (cached == cache.end()) {
+		response = sync();
+		store_cache(history_hash, response);
+	} else if (validate) {
+		response = sync();
+		if (response != cached->second) {
+			std::cerr << "WARNING: cached SPS response differs from server response" << std::endl;
+			store_cache(history_hash, response);
+		}
+	} else {
+		symbolic_stats.increment(SymbolicStats::SPS_CACHE_HITS);
+		response = cached->second;
+	}
+	symbolic_stats.increment(SymbolicStats::SPS_MESSAGES);
 
 	// XXX: Assumption previous messages has been fully received.
 	// See exception throw above.
-	lastMsg = std::make_unique<SymbolicFormat>(ctx, *sockin);
+	lastMsg = std::make_unique<SymbolicFormat>(ctx, response);
 }
 
 std::shared_ptr<clover::ConcolicValue>
@@ -19,11 +19,15 @@
 #define RISCV_VP_PROTOCOL_STATES_H
 
 #include <memory>
-#include <istream>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <stddef.h>
 #include <stdbool.h>
+#include <sys/types.h>
 #include <clover/clover.h>
-#include <ext/stdio_filebuf.h>
 
 #include "symbolic_format.h"
 #include "symbolic_context.h"
@@ -38,19 +42,54 @@ private:
 	int sockfd;
 	SymbolicContext &ctx;
 
-	// See https://gcc.gnu.org/onlinedocs/libstdc++/manual/ext_io.html
-	//
-	// XXX: For some reason, using a combined std::iostream for both
-	// reading and writing from/to the socket doesn't work.
-	__gnu_cxx::stdio_filebuf<char> *inbuf = nullptr;
-	__gnu_cxx::stdio_filebuf<char> *outbuf = nullptr;
-	std::istream *sockin = nullptr;
-	std::ostream *sockout = nullptr;
+	// Buffers for encoded requests and received responses, reused
+	// across messages. The receive buffer may contain more than one
+	// bencode value, rxlen is the amount of buffered bytes.
+	std::string txbuf;
+	std::vector<char> rxbuf;
+	size_t rxlen = 0;
 
 	std::unique_ptr<SymbolicFormat> lastMsg = nullptr;
 
+	// Messages send since the last reset and a hash of them. The
+	// server is only contacted on a cache miss, hence the messages
+	// processed by the server may lag behind. If the server state
+	// diverged (i.e. requires a reset) server_pos is std::nullopt.
+	std::vector<std::string> history;
+	uint64_t history_hash;
+	std::optional<size_t> server_pos = 0;
+
+	// Process which last used the connection. Processes forked while
+	// replaying test cases share the connection, the server state is
+	// thus unknown in a newly forked process.
+	pid_t owner;
+
+	// Cache of SPS responses keyed by the history hash.
+	std::unordered_map<uint64_t, std::string> cache;
+	std::ofstream cachefile;
+	bool validate;
+
+	void load_cache(std::string path);
+	void store_cache(uint64_t key, const std::string &response);
+
+	// Bring the server in the state described by all but the last
+	// element of the history, then transmit the last element.
+	std::string sync(void);
+	std::string transmit(const std::string &msg);
+
+	// Send the request encoded in txbuf and receive a response.
+	void send_request(void);
+	std::string recv_response(void);
+
 public:
-	ProtocolStates(SymbolicContext &_ctx, std::string host, std::string service);
+	// If the host starts with unix: the remainder is interpreted as
+	// the path of a unix domain socket and the service is ignored.
+	//
+	// If a cache file is given, responses are additionally
+	// persisted in this file. If validate is true, cached responses
+	// are compared against the response of the SPS server.
+	ProtocolStates(SymbolicContext &_ctx, std::string host, std::string service,
+	               std::string cache_path = "", bool validate = false);
 	~ProtocolStates(void);
 
 	// Reset SPS state machine.
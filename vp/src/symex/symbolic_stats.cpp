@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2022 Group of Computer Architecture, University of Bremen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <clover/clover.h>
+#include <klee/Solver/SolverStats.h>
+
+#include "symbolic_stats.h"
+
+SymbolicStats symbolic_stats;
+
+static const char *phase_names[SymbolicStats::PHASE_COUNT] = {
+	"elaboration",
+	"execution",
+	"sps",
+	"path_search",
+	"coverage",
+};
+
+static const char *counter_names[SymbolicStats::COUNTER_COUNT] = {
+	"sps_messages",
+	"sps_cache_hits",
+	"sps_requests",
+	"instructions",
+	"mutants",
+	"mutants_kept",
+};
+
+// KLEE timer statistics are recorded in microseconds.
+static double
+stat_seconds(const klee::Statistic &stat)
+{
+	return stat.getValue() / 1e6;
+}
+
+SymbolicStats::Timer::Timer(Phase _phase)
+	: phase(_phase), start(clock::now())
+{
+	return;
+}
+
+SymbolicStats::Timer::~Timer(void)
+{
+	stop();
+}
+
+void
+SymbolicStats::Timer::stop(void)
+{
+	if (!running)
+		return;
+
+	symbolic_stats.add(phase, clock::now() - start);
+	running = false;
+}
+
+double
+SymbolicStats::seconds(Phase phase)
+{
+	return std::chrono::duration<double>(phases[phase]).count();
+}
+
+uint64_t
+SymbolicStats::count(Counter counter)
+{
+	return counters[counter];
+}
+
+void
+SymbolicStats::dump_json(std::ostream &stream)
+{
+	stream << "{\"phases\":{";
+	for (size_t i = 0; i < PHASE_COUNT; i++)
+		stream << ((i) ? "," : "") << "\"" << phase_names[i] << "\":" << seconds((Phase)i);
+
+	stream << "},\"counters\":{";
+	for (size_t i = 0; i < COUNTER_COUNT; i++)
+		stream << ((i) ? "," : "") << "\"" << counter_names[i] << "\":" << count((Counter)i);
+
+	// Statistics of the layers in the solver chain (see clover::Solver).
+	stream << "},\"solver\":{"
+	       << "\"query_build\":" << stat_seconds(clover::stats::queryBuildTime) << ","
+	       << "\"query_cache_hits\":" << klee::stats::queryCacheHits.getValue() << ","
+	       << "\"query_cache_misses\":" << klee::stats::queryCacheMisses.getValue() << ","
+	       << "\"cex_cache_hits\":" << klee::stats::queryCexCacheHits.getValue() << ","
+	       << "\"cex_cache_misses\":" << klee::stats::queryCexCacheMisses.getValue() << ","
+	       << "\"cex_cache_time\":" << stat_seconds(klee::stats::cexCacheTime) << ","
+	       << "\"core_queries\":" << klee::stats::queries.getValue() << ","
+	       << "\"core_time\":" << stat_seconds(klee::stats::queryTime) << ","
+	       << "\"exprs_shared\":" << clover::stats::exprsShared.getValue() << ","
+	       << "\"exprs_unique\":" << clover::stats::exprsUnique.getValue() << ","
+	       << "\"conflicts_learned\":" << clover::stats::conflictsLearned.getValue() << ","
+	       << "\"conflicts_pruned\":" << clover::stats::conflictsPruned.getValue()
+	       << "}}";
+}
+
+void
+SymbolicStats::dump(std::ostream &stream)
+{
+	stream << "Time (seconds):";
+	for (size_t i = 0; i < PHASE_COUNT; i++)
+		stream << " " << phase_names[i] << "=" << seconds((Phase)i);
+	stream << std::endl;
+
+	stream << "Instructions: " << count(INSTRUCTIONS) << std::endl;
+
+	stream << "SPS Messages: " << count(SPS_MESSAGES)
+	       << " (" << count(SPS_CACHE_HITS) << " cache hits, "
+	       << count(SPS_REQUESTS) << " requests)" << std::endl;
+
+	stream << "Solver Queries: " << klee::stats::queries.getValue()
+	       << " (" << klee::stats::queryCacheHits.getValue() << " cache hits, "
+	       << klee::stats::queryCexCacheHits.getValue() << " cex cache hits, "
+	       << stat_seconds(klee::stats::queryTime) << " seconds)" << std::endl;
+
+	// Shared expressions did not require a new node in the DAG.
+	stream << "Expressions: " << clover::stats::exprsUnique.getValue() + clover::stats::exprsShared.getValue()
+	       << " (" << clover::stats::exprsShared.getValue() << " shared)" << std::endl;
+
+	if (count(MUTANTS) > 0)
+		stream << "Mutants: " << count(MUTANTS) << " (" << count(MUTANTS_KEPT) << " new coverage)" << std::endl;
+
+	// Pruned queries were not passed to the solver (see Trace::findNewPath).
+	stream << "Conflicts: " << clover::stats::conflictsLearned.getValue() << " learned, "
+	       << clover::stats::conflictsPruned.getValue() << " pruned" << std::endl;
+}
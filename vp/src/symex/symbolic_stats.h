@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2022 Group of Computer Architecture, University of Bremen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RISCV_ISA_SYMBOLIC_STATS_H
+#define RISCV_ISA_SYMBOLIC_STATS_H
+
+#include <chrono>
+#include <ostream>
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Lightweight instrumentation of the exploration. Time spent in each
+// phase is measured using a monotonic clock. Phases may be nested, e.g.
+// SPS round trips are also accounted to the EXECUTION phase.
+class SymbolicStats {
+public:
+	typedef std::chrono::steady_clock clock;
+
+	enum Phase {
+		ELABORATION, // Platform elaboration and ELF loading
+		EXECUTION,   // Simulation of the software
+		SPS,         // Round trips to the state protocol server
+		PATH_SEARCH, // Negating branch conditions, including the solver
+		COVERAGE,    // Per-path coverage bookkeeping
+		PHASE_COUNT,
+	};
+
+	enum Counter {
+		SPS_MESSAGES,   // Messages send to the SPS
+		SPS_CACHE_HITS, // Messages answered from the SPS cache
+		SPS_REQUESTS,   // Requests actually transmitted to the SPS
+		INSTRUCTIONS,   // Instructions executed by the ISS
+		MUTANTS,        // Executed mutations of explored inputs
+		MUTANTS_KEPT,   // Mutations added to the execution tree
+		COUNTER_COUNT,
+	};
+
+	// Accounts its lifetime, or the time until stop() is called,
+	// to the given phase.
+	class Timer {
+	private:
+		Phase phase;
+		clock::time_point start;
+		bool running = true;
+
+	public:
+		Timer(Phase _phase);
+		~Timer(void);
+
+		void stop(void);
+	};
+
+private:
+	clock::duration phases[PHASE_COUNT] = {};
+	uint64_t counters[COUNTER_COUNT] = {};
+
+public:
+	void add(Phase phase, clock::duration duration) {
+		phases[phase] += duration;
+	}
+
+	void increment(Counter counter, uint64_t n = 1) {
+		counters[counter] += n;
+	}
+
+	clock::duration elapsed(Phase phase) {
+		return phases[phase];
+	}
+
+	double seconds(Phase phase);
+	uint64_t count(Counter counter);
+
+	// Write all phases, counters, and solver statistics as a
+	// single JSON object (without a trailing newline).
+	void dump_json(std::ostream &stream);
+
+	// Write a human-readable summary.
+	void dump(std::ostream &stream);
+};
+
+extern SymbolicStats symbolic_stats;
+
+#endif